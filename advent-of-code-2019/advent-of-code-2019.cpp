@@ -1,24 +1,228 @@
 ﻿// advent-of-code-2019.cpp : Defines the entry point for the application.
 //
+// Usage: advent-of-code-2019 [-j jobs] [-n repeat] [-e engine] [-t] [day[:part]...]
+//
+// Runs the selected days, all of them by default, `jobs` at a time on a pool
+// of threads, so a full run takes about as long as its slowest day. Output
+// comes in day order whichever day finishes first. `-n` runs each part
+// `repeat` times, `-t` reports the best time of each part and `-e` picks
+// the Intcode engine: interpreter, jit or compiled.
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 #include "advent-of-code-2019.hpp"
 #include "days/day_factory.hpp"
+#include "days/intcode/intcode.hpp"
+#include "days/intcode/jit.hpp"
+#include "days/intcode/memo.hpp"
 #include "days/utils.hpp"
 
+namespace {
 
-int main()
-{
-	// I should add here some command line processing, but for now I'm too lazy.
-	for (int i = 1; i <= 25; i++) {
-		auto day_name = "day" + int_to_str(i);
-		auto day = DayFactory::create_day(day_name);
-		std::cout << "Solution for " << day_name << std::endl;
-		if (day != nullptr) {
-			std::cout << day->part_01() << std::endl;
-			std::cout << day->part_02() << std::endl;
+constexpr int last_day = 25;
+
+struct Options {
+	// Parts to run by day, in day order.
+	std::map<int, std::array<bool, 2>> days;
+	std::size_t jobs = std::max(1u, std::thread::hardware_concurrency());
+	int repeat = 1;
+	bool time = false;
+	std::optional<intcode::Tier> tier;
+};
+
+struct Report {
+	std::string text;
+	std::string error;
+};
+
+std::optional<int> parse_number(std::string_view text) {
+	int value = 0;
+	auto [last, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+	if (error != std::errc() || last != text.data() + text.size()) {
+		return std::nullopt;
+	}
+	return value;
+}
+
+std::optional<intcode::Tier> parse_tier(std::string_view name) {
+	if (name == "interpreter") {
+		return intcode::Tier::INTERPRETER;
+	}
+	if (name == "jit" && intcode::Jit::available()) {
+		return intcode::Tier::JIT;
+	}
+	if (name == "compiled") {
+		return intcode::Tier::COMPILED;
+	}
+	return std::nullopt;
+}
+
+// Reads `day` or `day:part`.
+bool parse_selection(std::string_view text, Options& options) {
+	auto colon = text.find(':');
+	auto day = parse_number(text.substr(0, colon));
+	if (!day || *day < 1 || *day > last_day) {
+		return false;
+	}
+	auto& parts = options.days[*day];
+	if (colon == std::string_view::npos) {
+		parts = {true, true};
+		return true;
+	}
+	auto part = parse_number(text.substr(colon + 1));
+	if (!part || *part < 1 || *part > 2) {
+		return false;
+	}
+	parts[static_cast<std::size_t>(*part - 1)] = true;
+	return true;
+}
+
+std::optional<Options> parse_options(int argc, char* argv[]) {
+	Options options;
+	for (int i = 1; i < argc; i++) {
+		std::string_view arg = argv[i];
+		// Value of an option, empty when missing.
+		auto value = [&]() -> std::string_view {
+			return i + 1 < argc ? argv[++i] : "";
+		};
+		if (arg == "-j" || arg == "--jobs") {
+			auto jobs = parse_number(value());
+			if (!jobs || *jobs < 1) {
+				return std::nullopt;
+			}
+			options.jobs = static_cast<std::size_t>(*jobs);
+		} else if (arg == "-n" || arg == "--repeat") {
+			auto repeat = parse_number(value());
+			if (!repeat || *repeat < 1) {
+				return std::nullopt;
+			}
+			options.repeat = *repeat;
+		} else if (arg == "-e" || arg == "--engine") {
+			options.tier = parse_tier(value());
+			if (!options.tier) {
+				return std::nullopt;
+			}
+		} else if (arg == "-t" || arg == "--time") {
+			options.time = true;
+		} else if (!parse_selection(arg, options)) {
+			return std::nullopt;
 		}
 	}
-	return 0;
+	if (options.days.empty()) {
+		for (int day = 1; day <= last_day; day++) {
+			options.days[day] = {true, true};
+		}
+	}
+	return options;
+}
+
+// Some days build the second part on what the first one worked out, so
+// each repetition runs the parts in order on a fresh day, the first one
+// unreported when only the second is selected. The memo is emptied first,
+// or every repetition after the first would time lookups of the outputs
+// the first one kept.
+Report run_day(int number, const std::array<bool, 2>& parts, const Options& options) {
+	using Clock = std::chrono::high_resolution_clock;
+	std::ostringstream os;
+	auto day_name = "day" + int_to_str(number);
+	os << "Solution for " << day_name << '\n';
+	std::array<std::string, 2> results;
+	std::array<Clock::duration, 2> best = {Clock::duration::max(), Clock::duration::max()};
+	try {
+		auto last = parts[1] ? 2u : 1u;
+		for (int i = 0; i < options.repeat; i++) {
+			intcode::get_memo().clear();
+			auto day = DayFactory::create_day(day_name);
+			if (!day) {
+				return {os.str(), ""};
+			}
+			for (std::size_t part = 0; part < last; part++) {
+				auto start = Clock::now();
+				results[part] = part == 0 ? day->part_01() : day->part_02();
+				best[part] = std::min(best[part], Clock::now() - start);
+			}
+		}
+	} catch (const std::exception& e) {
+		return {os.str(), day_name + ": " + e.what()};
+	}
+	for (std::size_t part = 0; part < results.size(); part++) {
+		if (!parts[part]) {
+			continue;
+		}
+		os << results[part] << '\n';
+		if (options.time) {
+			auto zero = Clock::time_point();
+			os << "  part " << part + 1 << " in " << duration_to_string(zero, zero + best[part]) << '\n';
+		}
+	}
+	return {os.str(), ""};
+}
+
+// Workers take the days in order; each report is printed once the ones
+// before it are. Returns the exit status.
+int run_days(const Options& options) {
+	std::vector<std::pair<int, std::array<bool, 2>>> days(options.days.begin(), options.days.end());
+	std::vector<std::optional<Report>> reports(days.size());
+	std::mutex m;
+	std::condition_variable cv;
+	std::atomic<std::size_t> next = 0;
+	auto work = [&] {
+		for (auto i = next++; i < days.size(); i = next++) {
+			auto report = run_day(days[i].first, days[i].second, options);
+			{
+				std::lock_guard lock(m);
+				reports[i] = std::move(report);
+			}
+			cv.notify_all();
+		}
+	};
+	std::vector<std::thread> threads;
+	for (std::size_t i = 0; i < std::min(options.jobs, days.size()); i++) {
+		threads.emplace_back(work);
+	}
+
+	int status = 0;
+	for (auto& report : reports) {
+		std::unique_lock lock(m);
+		cv.wait(lock, [&] { return report.has_value(); });
+		lock.unlock();
+		std::cout << report->text << std::flush;
+		if (!report->error.empty()) {
+			std::cerr << report->error << std::endl;
+			status = 1;
+		}
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	return status;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	auto options = parse_options(argc, argv);
+	if (!options) {
+		std::cerr << "usage: " << argv[0] << " [-j jobs] [-n repeat] [-e interpreter|jit|compiled] [-t] [day[:part]...]" << std::endl;
+		return 1;
+	}
+	if (options->tier) {
+		intcode::set_tier(*options->tier);
+	}
+	return run_days(*options);
 }
@@ -1,25 +1,43 @@
 #include "../day_factory.hpp"
+#include "../intcode/batch.hpp"
 #include "../intcode/intcode.hpp"
+#include "../intcode/symbolic.hpp"
 #include "../utils.hpp"
 #include "alarm.hpp"
 
 
 std::string Alarm::part_01() {
-	auto memory = intcode::get_memory_from_string(source);
+	const auto& memory = intcode::get_image_from_string(source);
 	auto program = intcode::get_program_for_memory_with_patched_data(memory, {12, 2});
-	intcode::run_program_on_computer_with_id(program, 0);
+	intcode::run_decoded_program_on_computer_with_id(program, 0);
 	return std::to_string(program.at(0).cpu.memory[0]);
 }
 
+// Solves for the noun and verb when the output is affine in them, as it is
+// for the puzzle inputs, otherwise tries every pair at once, one batch lane
+// each.
 std::string Alarm::part_02() {
-	for (int first = 0; first < 99; first++) {
-		for (int second = 0; second < 99; second++) {
-			auto memory = intcode::get_memory_from_string(source);
-			auto program = intcode::get_program_for_memory_with_patched_data(memory, {first, second});
-			intcode::run_program_on_computer_with_id(program, 0);
-			if (program.at(0).cpu.memory[0] == 19690720) {
-				return std::to_string(first) + int_to_str(second);
-			}
+	constexpr int range = 99;
+	constexpr intcode::Value target = 19690720;
+	auto memory = intcode::get_image_from_string(source).flatten();
+	auto result = intcode::run_symbolic(memory, {1, 2});
+	if (result && result->memory[0]) {
+		auto solution = intcode::solve(*result->memory[0], target, {0, 0}, {range - 1, range - 1});
+		if (!solution) {
+			return std::string();
+		}
+		return std::to_string((*solution)[0]) + int_to_str(static_cast<int>((*solution)[1]));
+	}
+
+	intcode::Batch batch(memory, range * range);
+	for (int lane = 0; lane < range * range; lane++) {
+		batch.patch(lane, 1, lane / range);
+		batch.patch(lane, 2, lane % range);
+	}
+	batch.run();
+	for (int lane = 0; lane < range * range; lane++) {
+		if (batch.get_state(lane) == intcode::Batch::State::HALTED && batch.get(lane, 0) == target) {
+			return std::to_string(lane / range) + int_to_str(lane % range);
 		}
 	}
 	return std::string();
@@ -1,5 +1,6 @@
 
 #include "../day_factory.hpp"
+#include "../intcode/memo.hpp"
 #include "asteroids.hpp"
 
 std::string Asteroids::part_01() {
@@ -11,10 +12,8 @@ std::string Asteroids::part_02() {
 }
 
 intcode::Value Asteroids::get_output_of_code_run_with_data(const intcode::Data& input_data) {
-	auto memory = intcode::get_memory_from_string(src);
-	auto program = intcode::get_program_for_memory_with_input_data(memory, input_data);
-	intcode::run_program_on_computer_with_id(program, 0);
-	return program.at(0).cpu.output.back();
+	const auto& memory = intcode::get_image_from_string(src);
+	return intcode::get_memo().run(memory, input_data).back();
 }
 
 std::unique_ptr<Day> Asteroids::create() {
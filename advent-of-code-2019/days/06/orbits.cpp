@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 
 #include "../day_factory.hpp"
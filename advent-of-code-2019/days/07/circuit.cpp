@@ -1,6 +1,8 @@
 #include <algorithm>
 
 #include "../day_factory.hpp"
+#include "../intcode/memo.hpp"
+#include "../intcode/scheduler.hpp"
 #include "circuit.hpp"
 
 
@@ -18,50 +20,51 @@ std::string Circuit::part_01() {
 }
 
 std::string Circuit::part_02() {
-	auto memory = intcode::get_memory_from_string(src);
 	intcode::Memory phase_settings = {5, 6, 7, 8, 9};
+	auto amplifiers = get_amplifiers_for_phase_settings(phase_settings);
 	int64_t max_thruster_signal = 0;
 	do {
 		max_thruster_signal = std::max(
 			max_thruster_signal,
-			run_program_with_phase_settings(memory, phase_settings)
+			run_program_with_phase_settings(amplifiers, phase_settings)
 		);
 	} while (std::next_permutation(phase_settings.begin(), phase_settings.end()));
 	return std::to_string(max_thruster_signal);
 }
 
+Circuit::Amplifiers Circuit::get_amplifiers_for_phase_settings(const intcode::Memory& phase_settings) {
+	const auto& memory = intcode::get_image_from_string(src);
+	Amplifiers amplifiers;
+	for (const auto& setting : phase_settings) {
+		auto program = intcode::get_program_for_memory_with_input_data(memory, {setting});
+		intcode::resume_decoded_program_on_computer_with_id(program, 0);
+		amplifiers.emplace(setting, program.at(0).snapshot());
+	}
+	return amplifiers;
+}
+
+// Amplifiers see the same (phase, signal) pairs across permutations, so
+// most runs come from the memo.
 int64_t Circuit::get_thruster_signal_for_phase_setting_sequence(const intcode::Memory& phase_setting) {
+	const auto& memory = intcode::get_image_from_string(src);
 	int64_t max_thruster_signal = 0;
 	for (const auto& setting : phase_setting) {
-		intcode::Data input = {setting, max_thruster_signal};
-		auto memory = intcode::get_memory_from_string(src);
-		auto program = intcode::get_program_for_memory_with_input_data(memory, input);
-		intcode::run_program_on_computer_with_id(program, 0);
-		max_thruster_signal = program.at(0).cpu.output.back();
+		max_thruster_signal = intcode::get_memo().run(memory, {setting, max_thruster_signal}).back();
 	}
 	return max_thruster_signal;
 }
 
-int64_t Circuit::run_program_with_phase_settings(intcode::Memory memory, intcode::Memory phase_settings) {
-	intcode::Hooks hooks = {
-		{
-			intcode::Type::INPUT,
-			[&](intcode::Program& /*program*/, intcode::Computer& comp, std::unique_ptr<intcode::Instruction>& inst) {
-				comp.wait_for_input();
-				inst->execute(comp.cpu);
-			}
-		},
-		{
-			intcode::Type::OUTPUT,
-			[&](intcode::Program& program, intcode::Computer& comp, std::unique_ptr<intcode::Instruction>& inst) {
-				inst->execute(comp.cpu);
-				program.at(comp.feed_to).add_to_input(comp.cpu.output.back());
-				comp.cpu.output.pop_back();
-			}
-		}
-	};
-	auto program = intcode::get_program_for_memory_with_phase_settings(memory, phase_settings);
-	intcode::run_program_with_phase_settings(program, phase_settings, hooks);
+// The amplifiers run in a ring on the scheduler, on this thread, until the
+// first one halts; the last signal is left waiting for it.
+int64_t Circuit::run_program_with_phase_settings(const Amplifiers& amplifiers, intcode::Memory phase_settings) {
+	intcode::Program program;
+	for (std::size_t i = 0; i < phase_settings.size(); i++) {
+		program.emplace(phase_settings[i], amplifiers.at(phase_settings[i]));
+		program.connect(phase_settings[i], phase_settings[(i + 1) % phase_settings.size()]);
+	}
+	intcode::Scheduler scheduler(program);
+	scheduler.send(phase_settings[0], 0);
+	scheduler.run();
 	return program.at(phase_settings[0]).cpu.input.back();
 }
 
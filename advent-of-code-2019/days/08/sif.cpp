@@ -1,5 +1,6 @@
-#include <iostream>
+#include <algorithm>
 #include <limits>
+#include <string>
 
 #include "sif.hpp"
 #include "../day_factory.hpp"
@@ -66,28 +67,29 @@ std::string SIF::part_02() {
 			idx++;
 		}
 	}
-	print_layer(lay, 25);
-	return std::string();
+	return render_layer(lay, 25);
 }
 
-void SIF::print_layer(const Layer& layer, Value width) {
+std::string SIF::render_layer(const Layer& layer, Value width) {
+	std::string result;
 	Value current_width = 0;
 	for (const auto& ch : layer) {
 		if (current_width >= width) {
-			std::cout << std::endl;
+			result += '\n';
 			current_width = 0;
 		}
 		current_width++;
 		switch (ch) {
 		case 0:
-			std::cout << ' ';
+			result += ' ';
 			break;
 		case 1:
-			std::cout << 'O';
+			result += 'O';
 			break;
 		case 2:
 		default:
 			break;
 		}
 	}
+	return result;
 }
@@ -21,7 +21,7 @@ protected:
 	Layers get_image_as_layers(const std::string& source, Value size);
 	Layers::const_iterator get_layer_with_fewest_zeros(const Layers& layers);
 	Value get_count_of_digit_in_layer(const Layer& layer, Value value);
-	void print_layer(const Layer& layer, Value width);
+	std::string render_layer(const Layer& layer, Value width);
 
 private:
 	static bool s_registered;
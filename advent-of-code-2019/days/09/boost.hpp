@@ -14,4 +14,5 @@ class Boost : public Day {
 	intcode::Value run_boost_program_with_input(const intcode::Data& input);
 private:
 	static bool s_registered;
+	#include "puzzle_input"
 };
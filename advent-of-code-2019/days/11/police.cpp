@@ -1,36 +1,11 @@
 #include <iostream>
-#include <thread>
+#include <limits>
+
 #include "../10/station.hpp"
 #include "../day_factory.hpp"
 #include "../intcode/intcode.hpp"
 #include "police.hpp"
 
-intcode::Hooks hooks = {
-	{
-		intcode::Type::INPUT,
-		[](intcode::Program&, intcode::Computer& comp, std::unique_ptr<intcode::Instruction>& inst) {
-			comp.wait_for_input();
-			inst->execute(comp.cpu);
-		}
-	},
-	{
-		intcode::Type::OUTPUT,
-		[](intcode::Program& program, intcode::Computer& comp, std::unique_ptr<intcode::Instruction>& inst) {
-			inst->execute(comp.cpu);
-			program.at(comp.feed_to).add_to_input(comp.cpu.output.back());
-			comp.cpu.output.pop_back();
-		}
-	},
-	{
-		intcode::Type::STOP,
-		[](intcode::Program& program, intcode::Computer& comp, std::unique_ptr<intcode::Instruction>&) {
-			program.at(comp.feed_to).add_to_input(-1);
-		}
-	}
-};
-
-std::map<Robot, intcode::Value, RobotCompare> surface;
-
 Robot::Robot(int64_t _x, int64_t _y) : Point(100*_x + _y, _x, _y, 0, 0), direction(0, -1) {}
 
 void Robot::adjust_direction(intcode::Value value) {
@@ -70,65 +45,38 @@ void Robot::adjust_direction(intcode::Value value) {
 	id = 100*x + y;
 }
 
-void run_robot(intcode::Program& program) {
+// Runs the brain, painting and moving the robot for every color and turn
+// it outputs and showing it the color of the panel below.
+void run_robot(intcode::Program& program, Surface& surface) {
 	Robot robot(0, 0);
-	auto& brain = program.at(1);
-	brain.wait_for_input_and_pop();
+	auto& brain = program.at(0);
 	for (;;) {
-		auto color = brain.wait_for_input_and_pop();
-		if (color == -1) {
-			break;
-		}
-		surface[robot] = color;
-		auto direction = brain.wait_for_input_and_pop();
-		robot.adjust_direction(direction);
-		if (surface.contains(robot)) {
-			color = surface[robot];
+		auto [event, output] = brain.run(2);
+		if (event == intcode::Event::OUTPUT) {
+			surface[robot] = output[0];
+			robot.adjust_direction(output[1]);
+			output.clear();
+		} else if (event == intcode::Event::INPUT) {
+			brain.cpu.input.push_back(surface.contains(robot) ? surface[robot] : 0);
 		} else {
-			color = 0;
+			return;
 		}
-		program.at(0).add_to_input(color);
 	}
 }
 
 std::string Police::part_01() {
-	auto memory = intcode::get_memory_from_string(src);
-	auto program = intcode::get_program_for_memory_with_phase_settings(memory, {0, 1});
-	program.at(0).cpu.input.pop_back();
-	auto brain = std::thread(
-		intcode::run_program_on_computer_with_id,
-		std::ref(program),
-		0,
-		hooks
-	);
-	auto robot = std::thread(
-		run_robot,
-		std::ref(program)
-	);
-	brain.join();
-	robot.join();
+	const auto& memory = intcode::get_image_from_string(src);
+	auto program = intcode::get_program_for_memory_with_input_data(memory, {0});
+	run_robot(program, surface);
 
 	return std::to_string(surface.size());
 }
 
 std::string Police::part_02() {
 	surface.clear();
-	auto memory = intcode::get_memory_from_string(src);
-	auto program = intcode::get_program_for_memory_with_phase_settings(memory, {0, 1});
-	program.at(0).cpu.input.pop_back();
-	program.at(0).cpu.input[0] = 1;
-	auto brain = std::thread(
-		intcode::run_program_on_computer_with_id,
-		std::ref(program),
-		0,
-		hooks
-	);
-	auto robot = std::thread(
-		run_robot,
-		std::ref(program)
-	);
-	brain.join();
-	robot.join();
+	const auto& memory = intcode::get_image_from_string(src);
+	auto program = intcode::get_program_for_memory_with_input_data(memory, {1});
+	run_robot(program, surface);
 
 	int64_t smallest_x = std::numeric_limits<int64_t>::max();
 	int64_t smallest_y = std::numeric_limits<int64_t>::max();
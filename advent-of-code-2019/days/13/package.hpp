@@ -40,34 +40,7 @@ public:
 		return "day13";
 	}
 
-	Tile get_tile_with_id(const Tiles& tiles, intcode::Value id) {
-		auto tile = std::find_if(tiles.begin(), tiles.end(), [&](const auto& tile) {
-			return tile.id == id;
-		});
-		if (tile != tiles.end())
-			return *tile;
-		return no_tile;
-	}
-
-	Tile get_score_tile(const Tiles& tiles) {
-		auto score = std::find_if(tiles.begin(), tiles.end(), [](const auto& tile) {
-			return tile.x == -1 && tile.y == 0;
-		});
-		if (score != tiles.end()) {
-			return *score;
-		}
-		return no_tile;
-	}
-
-	Tile get_ball_tile(const Tiles& tiles) {
-		return get_tile_with_id(tiles, 4);
-	}
-
-	Tile get_paddle_tile(const Tiles& tiles) {
-		return get_tile_with_id(tiles, 3);
-	}
-
 private:
 	static bool s_registered;
-	static Tile no_tile;
+	#include "puzzle_input"
 };
@@ -0,0 +1,273 @@
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+
+#include "analysis.hpp"
+
+namespace intcode {
+
+namespace {
+
+Parameter::Mode get_mode(const Operation& op, int i) {
+	return static_cast<Parameter::Mode>(op.modes[i]);
+}
+
+bool is_jump(const Operation& op) {
+	return op.opcode == Type::JNZ || op.opcode == Type::JZ;
+}
+
+// Whether a jump may not be taken.
+bool falls_through(const Operation& op) {
+	return get_mode(op, 0) != Parameter::Mode::IMMEDIATE || (op.operands[0] != 0) == (op.opcode == Type::JZ);
+}
+
+// Cell written through a constant address, -1 for none.
+Value get_destination(const Operation& op) {
+	switch (op.opcode) {
+	case Type::ADD:
+	case Type::MULTIPLY:
+	case Type::LT:
+	case Type::EQ:
+		return get_mode(op, 2) == Parameter::Mode::POSITION ? op.operands[2] : -1;
+	case Type::INPUT:
+		return get_mode(op, 0) == Parameter::Mode::POSITION ? op.operands[0] : -1;
+	default:
+		break;
+	}
+	return -1;
+}
+
+void write_operand(std::ostream& os, const Operation& op, int i) {
+	switch (get_mode(op, i)) {
+	case Parameter::Mode::POSITION:
+		os << "[" << op.operands[i] << "]";
+		break;
+	case Parameter::Mode::RELATIVE:
+		os << "[base" << (op.operands[i] < 0 ? "" : "+") << op.operands[i] << "]";
+		break;
+	default:
+		os << op.operands[i];
+		break;
+	}
+}
+
+} // namespace
+
+Analysis::Analysis(const Memory& memory) :
+	memory(memory),
+	owners(memory.size(), -1) {
+	discover();
+	find_regions();
+	// Operands written with constant addresses are read when executed.
+	for (const auto& [ip, op] : instructions) {
+		auto destination = get_destination(op);
+		if (destination >= 0 && destination < static_cast<Value>(memory.size()) && owners[destination] >= 0) {
+			code_writes.insert(destination);
+			if (owners[destination] != destination) {
+				owners[destination] = -1;
+			}
+		}
+	}
+	find_blocks();
+}
+
+void Analysis::discover() {
+	Code code;
+	PagedMemory paged(memory);
+	std::vector<Value> pending = {0};
+	while (!pending.empty()) {
+		auto ip = pending.back();
+		pending.pop_back();
+		if (ip < 0 || ip >= static_cast<Value>(memory.size()) || owners[ip] >= 0) {
+			continue;
+		}
+		Operation op;
+		try {
+			op = code.fetch(paged, ip);
+		} catch (const std::exception&) {
+			continue;
+		}
+		if (!claim(ip, op.length)) {
+			continue;
+		}
+		instructions[ip] = op;
+		auto next = ip + op.length;
+		switch (op.opcode) {
+		case Type::STOP:
+			break;
+		case Type::JNZ:
+		case Type::JZ:
+			if (get_mode(op, 1) == Parameter::Mode::IMMEDIATE) {
+				pending.push_back(op.operands[1]);
+			} else if (get_mode(op, 1) == Parameter::Mode::RELATIVE) {
+				returns.insert(ip);
+			}
+			if (falls_through(op)) {
+				pending.push_back(next);
+			}
+			break;
+		case Type::ADD:
+		case Type::MULTIPLY:
+			// Return addresses pushed by calls.
+			if (get_mode(op, 0) == Parameter::Mode::IMMEDIATE && get_mode(op, 1) == Parameter::Mode::IMMEDIATE) {
+				auto target = op.opcode == Type::ADD ?
+					op.operands[0] + op.operands[1] : op.operands[0] * op.operands[1];
+				if (get_mode(op, 2) == Parameter::Mode::RELATIVE) {
+					return_addresses.insert(target);
+				}
+				pending.push_back(target);
+			}
+			pending.push_back(next);
+			break;
+		default:
+			pending.push_back(next);
+			break;
+		}
+	}
+
+	for (const auto& [ip, op] : instructions) {
+		if (!is_jump(op) || get_mode(op, 1) != Parameter::Mode::IMMEDIATE) {
+			continue;
+		}
+		auto target = instructions.find(op.operands[1]);
+		if (target != instructions.end() && target->second.opcode == Type::BASE &&
+				get_mode(target->second, 0) == Parameter::Mode::IMMEDIATE && target->second.operands[0] > 0) {
+			functions.insert(target->first);
+			calls.emplace(target->first, ip);
+		}
+	}
+}
+
+bool Analysis::claim(Value ip, Value length) {
+	if (ip + length > static_cast<Value>(memory.size())) {
+		return false;
+	}
+	for (auto cell = ip; cell < ip + length; cell++) {
+		if (owners[cell] >= 0) {
+			return false;
+		}
+	}
+	for (auto cell = ip; cell < ip + length; cell++) {
+		owners[cell] = ip;
+	}
+	return true;
+}
+
+void Analysis::find_blocks() {
+	std::set<Value> leaders = {0};
+	for (const auto& [ip, op] : instructions) {
+		if (is_jump(op)) {
+			if (get_mode(op, 1) == Parameter::Mode::IMMEDIATE) {
+				leaders.insert(op.operands[1]);
+			}
+			leaders.insert(ip + op.length);
+		} else if (op.opcode == Type::STOP) {
+			leaders.insert(ip + op.length);
+		}
+	}
+	leaders.insert(return_addresses.begin(), return_addresses.end());
+
+	Block* block = nullptr;
+	for (auto it = instructions.begin(); it != instructions.end(); ++it) {
+		auto [ip, op] = *it;
+		if (!block || block->end != ip || leaders.count(ip)) {
+			block = &blocks.emplace(ip, Block{ip, ip, {}, false}).first->second;
+		}
+		block->end = ip + op.length;
+		auto following = std::next(it);
+		auto next_starts = following != instructions.end() && following->first == block->end;
+		if (is_jump(op)) {
+			if (get_mode(op, 1) != Parameter::Mode::IMMEDIATE) {
+				block->indirect = true;
+			} else if (instructions.count(op.operands[1])) {
+				block->successors.push_back(op.operands[1]);
+			}
+			if (falls_through(op) && next_starts) {
+				block->successors.push_back(block->end);
+			}
+			block = nullptr;
+		} else if (op.opcode == Type::STOP) {
+			block = nullptr;
+		} else if (next_starts && leaders.count(block->end)) {
+			block->successors.push_back(block->end);
+		}
+	}
+}
+
+void Analysis::find_regions() {
+	for (Value cell = 0; cell < static_cast<Value>(memory.size()); cell++) {
+		auto code = owners[cell] >= 0;
+		if (regions.empty() || regions.back().code != code) {
+			regions.push_back({cell, cell, code});
+		}
+		regions.back().end = cell + 1;
+	}
+}
+
+void Analysis::write(std::ostream& os) const {
+	for (const auto& region : regions) {
+		if (!region.code) {
+			for (auto cell = region.first; cell < region.end; cell++) {
+				if ((cell - region.first) % 8 == 0) {
+					os << (cell == region.first ? "" : "\n") << "\t" << cell << ":\tDATA\t";
+				} else {
+					os << ", ";
+				}
+				os << memory[static_cast<std::size_t>(cell)];
+			}
+			os << "\n";
+			continue;
+		}
+		for (auto it = instructions.lower_bound(region.first); it != instructions.end() && it->first < region.end; ++it) {
+			auto [ip, op] = *it;
+			if (functions.count(ip)) {
+				os << "function " << ip << ", called from " << calls.count(ip) << " sites\n";
+			}
+			auto block = blocks.find(ip);
+			if (block != blocks.end()) {
+				os << "block " << ip << " ->";
+				for (auto successor : block->second.successors) {
+					os << " " << successor;
+				}
+				os << (block->second.indirect ? " (indirect)" : "") << "\n";
+			}
+			os << "\t" << ip << ":\t" << get_operation_name(op.opcode);
+			for (int i = 0; i + 1 < op.length; i++) {
+				os << (i ? ", " : "\t");
+				write_operand(os, op, i);
+				if (code_writes.count(ip + 1 + i)) {
+					os << "*";
+				}
+			}
+			if (code_writes.count(ip)) {
+				os << "\t; rewritten";
+			}
+			if (returns.count(ip)) {
+				os << "\t; return";
+			}
+			os << "\n";
+		}
+	}
+}
+
+const Analysis& get_analysis(const Memory& memory) {
+	static std::mutex m;
+	static std::unordered_multimap<std::size_t, Analysis> analyses;
+
+	std::string_view bytes(reinterpret_cast<const char*>(memory.data()), memory.size() * sizeof(Value));
+	auto hash = std::hash<std::string_view>()(bytes);
+	std::lock_guard lock(m);
+	auto [first, last] = analyses.equal_range(hash);
+	for (auto analysis = first; analysis != last; analysis++) {
+		if (analysis->second.get_memory() == memory) {
+			return analysis->second;
+		}
+	}
+	return analyses.emplace(std::piecewise_construct, std::make_tuple(hash), std::make_tuple(std::cref(memory)))->second;
+}
+
+} // intcode
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <map>
+#include <ostream>
+#include <set>
+#include <vector>
+
+#include "intcode.hpp"
+
+namespace intcode {
+
+// Static structure of a program: the instructions reachable from address 0
+// following fall-through, jumps to immediate targets and the return
+// addresses calls compute from immediates. Jumps to computed targets end
+// their block without successors.
+class Analysis {
+public:
+	// Straight-line run of instructions entered at its first one only.
+	struct Block {
+		Value first;
+		// One past the last cell of its last instruction.
+		Value end;
+		std::vector<Value> successors;
+		// Ends in a jump to a computed target, as returns do.
+		bool indirect = false;
+	};
+
+	// Cells `[first, end)`, all owned by instructions or all data.
+	struct Region {
+		Value first;
+		Value end;
+		bool code;
+	};
+
+	explicit Analysis(const Memory& memory);
+
+	const Memory& get_memory() const {
+		return memory;
+	}
+	// Undecodable instructions end the paths reaching them.
+	const std::map<Value, Operation>& get_instructions() const {
+		return instructions;
+	}
+	// Instruction each cell belongs to, -1 for data and for operands the
+	// program writes through a constant address, which are read as data.
+	const std::vector<Value>& get_owners() const {
+		return owners;
+	}
+	// Blocks by first address.
+	const std::map<Value, Block>& get_blocks() const {
+		return blocks;
+	}
+	const std::vector<Region>& get_regions() const {
+		return regions;
+	}
+	// Cells of instructions written through constant addresses: opcodes and
+	// operands the program rewrites.
+	const std::set<Value>& get_code_writes() const {
+		return code_writes;
+	}
+	// Call convention over BASE: functions start by moving the base up by
+	// an immediate, returns jump to a relative-mode target.
+	const std::set<Value>& get_functions() const {
+		return functions;
+	}
+	// Call sites by function entered.
+	const std::multimap<Value, Value>& get_calls() const {
+		return calls;
+	}
+	const std::set<Value>& get_returns() const {
+		return returns;
+	}
+
+	// Listing of the regions, instructions annotated with their block,
+	// function and self-modification roles.
+	void write(std::ostream& os) const;
+
+private:
+	void discover();
+	bool claim(Value ip, Value length);
+	void find_blocks();
+	void find_regions();
+
+	const Memory memory;
+	std::map<Value, Operation> instructions;
+	std::vector<Value> owners;
+	std::map<Value, Block> blocks;
+	std::vector<Region> regions;
+	std::set<Value> code_writes;
+	std::set<Value> functions;
+	std::multimap<Value, Value> calls;
+	std::set<Value> returns;
+	// Targets computed from immediates by ADD and MULTIPLY, when pushed
+	// onto the stack at the relative base.
+	std::set<Value> return_addresses;
+};
+
+// Analyses each distinct program once per process; the analysis returned
+// lives until exit.
+const Analysis& get_analysis(const Memory& memory);
+
+} // intcode
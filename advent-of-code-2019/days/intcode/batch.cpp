@@ -0,0 +1,615 @@
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "batch.hpp"
+
+namespace intcode {
+
+namespace {
+
+using Narrow = int32_t;
+
+bool fits(Value value) {
+	return value >= std::numeric_limits<Narrow>::min() && value <= std::numeric_limits<Narrow>::max();
+}
+
+// Combines two rows of lane values into a third. Returns false when a lane
+// overflows, leaving the third row undefined; kernels that can fail never
+// write to a row they read.
+template<typename Cell>
+using Kernel = bool (*)(Cell* destination, const Cell* a, const Cell* b, std::size_t size);
+
+// Kernel for the opcode, instantiated by `make` from a constant.
+template<typename Make>
+auto select(Type opcode, Make make) -> decltype(make(std::integral_constant<Type, Type::ADD>())) {
+	switch (opcode) {
+	case Type::ADD:
+		return make(std::integral_constant<Type, Type::ADD>());
+	case Type::MULTIPLY:
+		return make(std::integral_constant<Type, Type::MULTIPLY>());
+	case Type::LT:
+		return make(std::integral_constant<Type, Type::LT>());
+	case Type::EQ:
+		return make(std::integral_constant<Type, Type::EQ>());
+	default:
+		break;
+	}
+	return {};
+}
+
+template<Type opcode>
+Value apply(Value a, Value b) {
+	switch (opcode) {
+	case Type::ADD:
+		return static_cast<Value>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b));
+	case Type::MULTIPLY:
+		return static_cast<Value>(static_cast<uint64_t>(a) * static_cast<uint64_t>(b));
+	case Type::LT:
+		return a < b ? 1 : 0;
+	case Type::EQ:
+		return a == b ? 1 : 0;
+	default:
+		break;
+	}
+	return 0;
+}
+
+// As `apply`, false when the result does not fit a cell.
+template<Type opcode, typename Cell>
+bool apply_checked(Cell a, Cell b, Cell& result) {
+	switch (opcode) {
+	case Type::ADD:
+		return !__builtin_add_overflow(a, b, &result);
+	case Type::MULTIPLY:
+		return !__builtin_mul_overflow(a, b, &result);
+	case Type::LT:
+		result = a < b ? 1 : 0;
+		return true;
+	case Type::EQ:
+		result = a == b ? 1 : 0;
+		return true;
+	default:
+		break;
+	}
+	return false;
+}
+
+Value evaluate(Type opcode, Value a, Value b, bool checked) {
+	auto result = select(opcode, [&](auto op) -> std::optional<Value> {
+		if (!checked) {
+			return apply<op.value>(a, b);
+		}
+		Value value;
+		return apply_checked<op.value>(a, b, value) ? std::optional<Value>(value) : std::nullopt;
+	});
+	if (!result) {
+		throw std::overflow_error("intcode: " + get_operation_name(opcode) + " overflows 64 bits");
+	}
+	return *result;
+}
+
+template<Type opcode>
+bool combine(Value* destination, const Value* a, const Value* b, std::size_t size) {
+	for (std::size_t i = 0; i < size; i++) {
+		destination[i] = apply<opcode>(a[i], b[i]);
+	}
+	return true;
+}
+
+template<Type opcode, typename Cell>
+bool combine_checked(Cell* destination, const Cell* a, const Cell* b, std::size_t size) {
+	bool fit = true;
+	for (std::size_t i = 0; i < size; i++) {
+		fit &= apply_checked<opcode>(a[i], b[i], destination[i]);
+	}
+	return fit;
+}
+
+#if defined(__x86_64__)
+
+template<Type opcode>
+__attribute__((target("avx2")))
+bool combine_avx2(Value* destination, const Value* a, const Value* b, std::size_t size) {
+	const auto one = _mm256_set1_epi64x(1);
+	std::size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+		auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+		__m256i result;
+		if constexpr (opcode == Type::ADD) {
+			result = _mm256_add_epi64(x, y);
+		} else if constexpr (opcode == Type::MULTIPLY) {
+			// No 64-bit multiply in AVX2: low halves plus shifted cross products.
+			auto low = _mm256_mul_epu32(x, y);
+			auto cross = _mm256_add_epi64(
+				_mm256_mul_epu32(_mm256_srli_epi64(x, 32), y),
+				_mm256_mul_epu32(x, _mm256_srli_epi64(y, 32)));
+			result = _mm256_add_epi64(low, _mm256_slli_epi64(cross, 32));
+		} else if constexpr (opcode == Type::LT) {
+			result = _mm256_and_si256(_mm256_cmpgt_epi64(y, x), one);
+		} else {
+			result = _mm256_and_si256(_mm256_cmpeq_epi64(x, y), one);
+		}
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), result);
+	}
+	for (; i < size; i++) {
+		destination[i] = apply<opcode>(a[i], b[i]);
+	}
+	return true;
+}
+
+// Eight 32-bit lanes per vector, with overflows gathered as set bits.
+template<Type opcode>
+__attribute__((target("avx2")))
+bool combine_narrow_avx2(Narrow* destination, const Narrow* a, const Narrow* b, std::size_t size) {
+	const auto one = _mm256_set1_epi32(1);
+	const auto sign = _mm256_set1_epi32(std::numeric_limits<Narrow>::min());
+	const auto low = _mm256_set1_epi64x(0xffffffff);
+	auto overflow = _mm256_setzero_si256();
+	std::size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+		auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+		__m256i result;
+		if constexpr (opcode == Type::ADD) {
+			// Overflowed when the sum's sign differs from both addends'.
+			result = _mm256_add_epi32(x, y);
+			auto flipped = _mm256_and_si256(_mm256_xor_si256(x, result), _mm256_xor_si256(y, result));
+			overflow = _mm256_or_si256(overflow, _mm256_and_si256(flipped, sign));
+		} else if constexpr (opcode == Type::MULTIPLY) {
+			// Full products of the even and odd lanes fit when their high
+			// halves repeat the sign of their low halves.
+			result = _mm256_mullo_epi32(x, y);
+			for (auto product : {_mm256_mul_epi32(x, y),
+					_mm256_mul_epi32(_mm256_srli_epi64(x, 32), _mm256_srli_epi64(y, 32))}) {
+				auto high = _mm256_srli_epi64(product, 32);
+				auto extended = _mm256_srai_epi32(product, 31);
+				overflow = _mm256_or_si256(overflow, _mm256_and_si256(_mm256_xor_si256(high, extended), low));
+			}
+		} else if constexpr (opcode == Type::LT) {
+			result = _mm256_and_si256(_mm256_cmpgt_epi32(y, x), one);
+		} else {
+			result = _mm256_and_si256(_mm256_cmpeq_epi32(x, y), one);
+		}
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), result);
+	}
+	bool fit = _mm256_testz_si256(overflow, overflow);
+	for (; i < size; i++) {
+		fit &= apply_checked<opcode>(a[i], b[i], destination[i]);
+	}
+	return fit;
+}
+
+#endif
+
+Kernel<Value> get_kernel(Type opcode, bool avx2, bool checked) {
+	return select(opcode, [&](auto op) -> Kernel<Value> {
+		if (checked) {
+			return combine_checked<op.value, Value>;
+		}
+#if defined(__x86_64__)
+		if (avx2) {
+			return combine_avx2<op.value>;
+		}
+#endif
+		return combine<op.value>;
+	});
+}
+
+Kernel<Narrow> get_narrow_kernel(Type opcode, bool avx2) {
+	return select(opcode, [&](auto op) -> Kernel<Narrow> {
+#if defined(__x86_64__)
+		if (avx2) {
+			return combine_narrow_avx2<op.value>;
+		}
+#endif
+		return combine_checked<op.value, Narrow>;
+	});
+}
+
+Parameter::Mode mode(const Operation& op, int i) {
+	return static_cast<Parameter::Mode>(op.modes[i]);
+}
+
+} // namespace
+
+Batch::Batch(const Memory& memory, std::size_t lanes, bool narrow) :
+	input(lanes),
+	output(lanes),
+	lanes(lanes),
+	// Rows padded to whole AVX2 vectors of narrow cells.
+	stride((lanes + 7) & ~std::size_t{7}),
+	narrow(narrow && std::all_of(memory.begin(), memory.end(), fits)),
+	rows(memory.size(), Row::UNIFORM),
+	// Two constant rows and a result.
+	narrow_scratch(3 * stride),
+	scratch(3 * stride),
+	base(lanes, 0),
+	states(lanes, State::RUNNING),
+	peeled_memory(lanes) {
+	if (this->narrow) {
+		narrow_cells.resize(memory.size() * stride);
+		for (std::size_t cell = 0; cell < memory.size(); cell++) {
+			std::fill_n(narrow_cells.begin() + cell * stride, stride, static_cast<Narrow>(memory[cell]));
+		}
+	} else {
+		cells.resize(memory.size() * stride);
+		for (std::size_t cell = 0; cell < memory.size(); cell++) {
+			std::fill_n(cells.begin() + cell * stride, stride, memory[cell]);
+		}
+	}
+	for (std::size_t lane = 0; lane < lanes; lane++) {
+		active.push_back(lane);
+	}
+}
+
+bool Batch::has_avx2() {
+#if defined(__x86_64__)
+	return __builtin_cpu_supports("avx2");
+#else
+	return false;
+#endif
+}
+
+void Batch::patch(std::size_t lane, Value location, Value value) {
+	if (!grow(location)) {
+		throw std::out_of_range("intcode: patching address " + std::to_string(location) + " out of reach");
+	}
+	set_cell(location, lane, value);
+	rows[location] = Row::UNKNOWN;
+}
+
+void Batch::run() {
+	while (!active.empty()) {
+		step();
+	}
+}
+
+std::size_t Batch::size() const {
+	return lanes;
+}
+
+Batch::State Batch::get_state(std::size_t lane) const {
+	return states.at(lane);
+}
+
+Value Batch::get(std::size_t lane, Value location) const {
+	const auto& memory = peeled_memory.at(lane);
+	auto cell = static_cast<std::size_t>(location);
+	if (memory.size()) {
+		return memory[cell];
+	}
+	return cell < rows.size() ? get_cell(location, lane) : 0;
+}
+
+Value* Batch::row(Value location) {
+	return cells.data() + static_cast<std::size_t>(location) * stride;
+}
+
+Batch::Narrow* Batch::narrow_row(Value location) {
+	return narrow_cells.data() + static_cast<std::size_t>(location) * stride;
+}
+
+Value Batch::get_cell(Value location, std::size_t lane) const {
+	auto at = static_cast<std::size_t>(location) * stride + lane;
+	return narrow ? narrow_cells[at] : cells[at];
+}
+
+void Batch::set_cell(Value location, std::size_t lane, Value value) {
+	if (narrow && !fits(value)) {
+		promote();
+	}
+	auto at = static_cast<std::size_t>(location) * stride + lane;
+	if (narrow) {
+		narrow_cells[at] = static_cast<Narrow>(value);
+	} else {
+		cells[at] = value;
+	}
+}
+
+// Widens every cell, for good: programs that overflow once tend to keep
+// producing large values.
+void Batch::promote() {
+	cells.assign(narrow_cells.begin(), narrow_cells.end());
+	narrow_cells = {};
+	narrow = false;
+}
+
+// Only lanes still running count, so the answer holds as lanes leave.
+bool Batch::is_uniform(Value location) {
+	auto& state = rows[location];
+	if (state == Row::UNKNOWN) {
+		auto first = get_cell(location, active.front());
+		state = std::all_of(active.begin(), active.end(), [&](auto lane) {
+			return get_cell(location, lane) == first;
+		}) ? Row::UNIFORM : Row::MIXED;
+	}
+	return state == Row::UNIFORM;
+}
+
+// Rows are dense in every lane, so they only grow near the cells in use;
+// lanes touching far addresses are peeled onto sparse memory instead.
+bool Batch::is_near(Value location) const {
+	return location >= 0 &&
+		static_cast<std::size_t>(location) < std::max<std::size_t>(rows.size() * 2, PagedMemory::page_size);
+}
+
+bool Batch::grow(Value location) {
+	if (!is_near(location)) {
+		return false;
+	}
+	auto cell = static_cast<std::size_t>(location);
+	if (cell >= rows.size()) {
+		if (narrow) {
+			narrow_cells.resize((cell + 1) * stride, 0);
+		} else {
+			cells.resize((cell + 1) * stride, 0);
+		}
+		rows.resize(cell + 1, Row::UNIFORM);
+	}
+	return true;
+}
+
+void Batch::step() {
+	if (ip < 0 || static_cast<std::size_t>(ip) >= rows.size()) {
+		fault_active();
+		return;
+	}
+	// Lanes whose code was patched differently leave the group.
+	if (!is_uniform(ip)) {
+		auto word = get_cell(ip, active.front());
+		std::vector<std::size_t> staying;
+		for (auto lane : active) {
+			if (get_cell(ip, lane) == word) {
+				staying.push_back(lane);
+			} else {
+				peel(lane, ip);
+			}
+		}
+		active = std::move(staying);
+		rows[ip] = Row::UNIFORM;
+	}
+
+	auto word = get_cell(ip, active.front());
+	Operation op = {};
+	op.opcode = static_cast<Type>(word % 100);
+	op.length = get_operation_length(op.opcode);
+	if (!op.length || ip + op.length > static_cast<Value>(rows.size())) {
+		fault_active();
+		return;
+	}
+	op.span = op.length;
+	bool uniform = true;
+	auto modes = word / 100;
+	for (int i = 0; i < op.length - 1; i++) {
+		op.operands[i] = get_cell(ip + 1 + i, active.front());
+		op.modes[i] = static_cast<uint8_t>(modes % 10);
+		modes /= 10;
+		uniform = uniform && is_uniform(ip + 1 + i) && mode(op, i) != Parameter::Mode::RELATIVE;
+	}
+
+	switch (op.opcode) {
+	case Type::ADD:
+	case Type::MULTIPLY:
+	case Type::LT:
+	case Type::EQ:
+		if (uniform) {
+			execute_vector(op);
+			return;
+		}
+		break;
+	case Type::STOP:
+		for (auto lane : active) {
+			states[lane] = State::HALTED;
+		}
+		active.clear();
+		return;
+	default:
+		break;
+	}
+	execute_lanes(op);
+}
+
+void Batch::execute_vector(const Operation& op) {
+	auto destination = op.operands[2];
+	for (int i = 0; i < 3; i++) {
+		if (mode(op, i) != Parameter::Mode::IMMEDIATE && op.operands[i] >= 0 && !is_near(op.operands[i])) {
+			execute_lanes(op);
+			return;
+		}
+	}
+	for (int i = 0; i < 2; i++) {
+		if (mode(op, i) != Parameter::Mode::IMMEDIATE && !grow(op.operands[i])) {
+			destination = -1;
+		}
+	}
+	if (!grow(destination)) {
+		fault_active();
+		return;
+	}
+	for (int i = 0; i < 2; i++) {
+		if (narrow && mode(op, i) == Parameter::Mode::IMMEDIATE && !fits(op.operands[i])) {
+			promote();
+		}
+	}
+	if (narrow) {
+		const Narrow* sources[2];
+		for (int i = 0; i < 2; i++) {
+			if (mode(op, i) == Parameter::Mode::IMMEDIATE) {
+				auto constant = narrow_scratch.data() + i * stride;
+				std::fill_n(constant, stride, static_cast<Narrow>(op.operands[i]));
+				sources[i] = constant;
+			} else {
+				sources[i] = narrow_row(op.operands[i]);
+			}
+		}
+		auto result = narrow_scratch.data() + 2 * stride;
+		if (get_narrow_kernel(op.opcode, avx2)(result, sources[0], sources[1], stride)) {
+			std::copy_n(result, stride, narrow_row(destination));
+		} else {
+			promote();
+		}
+	}
+	if (!narrow) {
+		const Value* sources[2];
+		for (int i = 0; i < 2; i++) {
+			if (mode(op, i) == Parameter::Mode::IMMEDIATE) {
+				auto constant = scratch.data() + i * stride;
+				std::fill_n(constant, stride, op.operands[i]);
+				sources[i] = constant;
+			} else {
+				sources[i] = row(op.operands[i]);
+			}
+		}
+		auto kernel = get_kernel(op.opcode, avx2, checked);
+		if (!checked) {
+			kernel(row(destination), sources[0], sources[1], stride);
+		} else if (auto result = scratch.data() + 2 * stride; kernel(result, sources[0], sources[1], stride)) {
+			std::copy_n(result, stride, row(destination));
+		} else {
+			// Overflowing lanes fault one by one.
+			execute_lanes(op);
+			return;
+		}
+	}
+	rows[destination] = Row::UNKNOWN;
+	ip += op.length;
+	vector_steps++;
+}
+
+void Batch::execute_lanes(const Operation& op) {
+	struct Far {};
+	std::vector<std::pair<std::size_t, Value>> next;
+	for (auto lane : active) {
+		auto lane_op = op;
+		for (int i = 0; i < op.length - 1; i++) {
+			lane_op.operands[i] = get_cell(ip + 1 + i, lane);
+		}
+		auto address = [&](int i) {
+			auto location = lane_op.operands[i];
+			if (mode(lane_op, i) == Parameter::Mode::RELATIVE) {
+				location += base[lane];
+			}
+			if (location >= 0 && !is_near(location)) {
+				throw Far{};
+			}
+			if (!grow(location)) {
+				throw std::out_of_range("intcode: negative address");
+			}
+			return location;
+		};
+		auto load = [&](int i) {
+			if (mode(lane_op, i) == Parameter::Mode::IMMEDIATE) {
+				return lane_op.operands[i];
+			}
+			return get_cell(address(i), lane);
+		};
+		auto store = [&](int i, Value value) {
+			auto location = address(i);
+			set_cell(location, lane, value);
+			rows[location] = Row::UNKNOWN;
+		};
+		auto lane_ip = ip + op.length;
+		try {
+			switch (op.opcode) {
+			case Type::ADD:
+			case Type::MULTIPLY:
+			case Type::LT:
+			case Type::EQ:
+				store(2, evaluate(op.opcode, load(0), load(1), checked));
+				break;
+			case Type::INPUT:
+				if (input[lane].empty()) {
+					throw std::runtime_error("intcode: missing input");
+				}
+				store(0, input[lane].front());
+				input[lane].pop_front();
+				break;
+			case Type::OUTPUT:
+				output[lane].push_back(load(0));
+				break;
+			case Type::JNZ:
+				if (load(0) != 0) {
+					lane_ip = load(1);
+				}
+				break;
+			case Type::JZ:
+				if (load(0) == 0) {
+					lane_ip = load(1);
+				}
+				break;
+			case Type::BASE:
+				base[lane] += load(0);
+				break;
+			default:
+				break;
+			}
+			next.emplace_back(lane, lane_ip);
+		} catch (const Far&) {
+			// Nothing was written yet, so the lane reruns the instruction.
+			peel(lane, ip);
+		} catch (const std::exception&) {
+			states[lane] = State::FAULTED;
+		}
+	}
+	lane_steps++;
+
+	// Lanes branching away from the first one are peeled off.
+	active.clear();
+	if (next.empty()) {
+		return;
+	}
+	ip = next.front().second;
+	for (const auto& [lane, lane_ip] : next) {
+		if (lane_ip == ip) {
+			active.push_back(lane);
+		} else {
+			peel(lane, lane_ip);
+		}
+	}
+}
+
+void Batch::peel(std::size_t lane, Value lane_ip) {
+	Memory image(rows.size());
+	for (std::size_t cell = 0; cell < rows.size(); cell++) {
+		image[cell] = get_cell(static_cast<Value>(cell), lane);
+	}
+	PagedMemory memory(image);
+	CPU cpu(memory, input[lane], output[lane], base[lane]);
+	cpu.ip = lane_ip;
+	cpu.code.keep_unfused({Type::INPUT});
+	try {
+		for (;;) {
+			const auto op = cpu.code.fetch(cpu.memory, cpu.ip);
+			if (op.opcode == Type::INPUT && cpu.input.empty()) {
+				throw std::runtime_error("intcode: missing input");
+			}
+			op.execute(cpu);
+			if (op.opcode == Type::STOP) {
+				break;
+			}
+		}
+		states[lane] = State::HALTED;
+	} catch (const std::exception&) {
+		states[lane] = State::FAULTED;
+	}
+	peeled_memory[lane] = std::move(memory);
+	peeled++;
+}
+
+void Batch::fault_active() {
+	for (auto lane : active) {
+		states[lane] = State::FAULTED;
+	}
+	active.clear();
+}
+
+} // intcode
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <vector>
+
+#include "intcode.hpp"
+
+namespace intcode {
+
+// Runs many instances of one program in lockstep, for sweeps over inputs.
+// Memory is laid out structure-of-arrays, each cell holding one value per
+// lane, so an instruction whose operands agree across lanes runs as a single
+// vector operation over the rows involved. Operands that differ are handled
+// lane by lane, still in lockstep; lanes whose control flow leaves the
+// others are peeled off and finished on the decoded interpreter.
+//
+// Cells start as 32-bit values when the image allows, halving the rows and
+// doubling the lanes per vector, until the first value that does not fit
+// promotes the whole batch to 64 bits.
+class Batch {
+public:
+	enum class State {
+		RUNNING,
+		HALTED,
+		// Invalid opcode, address or missing input, or an overflow when
+		// checked.
+		FAULTED,
+	};
+
+	Batch(const Memory& memory, std::size_t lanes, bool narrow = true);
+
+	static bool has_avx2();
+
+	void patch(std::size_t lane, Value location, Value value);
+	void run();
+
+	std::size_t size() const;
+	State get_state(std::size_t lane) const;
+	Value get(std::size_t lane, Value location) const;
+	// Whether cells are still 32-bit.
+	bool is_narrow() const {
+		return narrow;
+	}
+
+	// Whether to use the AVX2 kernels, when the processor has them.
+	bool avx2 = has_avx2();
+	// Whether lanes whose ADD or MULTIPLY overflows 64 bits fault instead
+	// of wrapping around.
+	bool checked = false;
+	std::vector<Data> input;
+	std::vector<Data> output;
+
+	// Instructions run as vector operations, run lane by lane, and lanes
+	// peeled off.
+	uint64_t vector_steps = 0;
+	uint64_t lane_steps = 0;
+	uint64_t peeled = 0;
+
+private:
+	enum class Row : uint8_t {
+		UNIFORM,
+		MIXED,
+		UNKNOWN,
+	};
+
+	using Narrow = int32_t;
+
+	Value* row(Value location);
+	Narrow* narrow_row(Value location);
+	Value get_cell(Value location, std::size_t lane) const;
+	void set_cell(Value location, std::size_t lane, Value value);
+	void promote();
+	bool is_uniform(Value location);
+	bool is_near(Value location) const;
+	bool grow(Value location);
+	void step();
+	void execute_vector(const Operation& op);
+	void execute_lanes(const Operation& op);
+	void peel(std::size_t lane, Value lane_ip);
+	void fault_active();
+
+	std::size_t lanes;
+	std::size_t stride;
+	// Rows live in `narrow_cells` until promoted, then in `cells`.
+	bool narrow;
+	std::vector<Narrow> narrow_cells;
+	std::vector<Value> cells;
+	std::vector<Row> rows;
+	std::vector<Narrow> narrow_scratch;
+	std::vector<Value> scratch;
+	std::vector<Value> base;
+	std::vector<State> states;
+	std::vector<std::size_t> active;
+	std::vector<PagedMemory> peeled_memory;
+	Value ip = 0;
+};
+
+} // intcode
@@ -0,0 +1,51 @@
+#include <thread>
+
+#include "channel.hpp"
+
+namespace intcode {
+
+namespace {
+
+// Busy polls, then polls yielding the core, before parking.
+constexpr int spin_limit = 128;
+constexpr int yield_limit = 16;
+
+inline void relax() {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#endif
+}
+
+// Waits until `index` moves away from `idle`, parking the thread on it when
+// polling does not pay off. The other side notifies when `parked` is set.
+void wait_while(std::atomic<uint64_t>& index, uint64_t idle, std::atomic<bool>& parked) {
+	for (int i = 0; i < spin_limit; i++) {
+		if (index.load(std::memory_order_acquire) != idle) {
+			return;
+		}
+		relax();
+	}
+	for (int i = 0; i < yield_limit; i++) {
+		if (index.load(std::memory_order_acquire) != idle) {
+			return;
+		}
+		std::this_thread::yield();
+	}
+	parked.store(true, std::memory_order_seq_cst);
+	if (index.load(std::memory_order_seq_cst) == idle) {
+		index.wait(idle, std::memory_order_acquire);
+	}
+	parked.store(false, std::memory_order_relaxed);
+}
+
+} // namespace
+
+void Channel::wait_for_room() {
+	wait_while(head, tail.load(std::memory_order_relaxed) - capacity, producer_parked);
+}
+
+void Channel::wait_for_data() {
+	wait_while(tail, head.load(std::memory_order_relaxed), consumer_parked);
+}
+
+} // intcode
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "paged_memory.hpp"
+
+namespace intcode {
+
+// Bounded lock-free ring buffer linking one producing thread to one
+// consuming thread. A side finding the ring empty (or full) spins for a
+// while before parking on the other side's index.
+class Channel {
+public:
+	static constexpr std::size_t capacity = 64;
+
+	Channel() = default;
+	Channel(const Channel&) = delete;
+	Channel& operator=(const Channel&) = delete;
+
+	bool try_push(Value value) {
+		auto position = tail.load(std::memory_order_relaxed);
+		if (position - head_cache == capacity) {
+			head_cache = head.load(std::memory_order_acquire);
+			if (position - head_cache == capacity) {
+				return false;
+			}
+		}
+		slots[position % capacity] = value;
+		tail.store(position + 1, std::memory_order_seq_cst);
+		if (consumer_parked.load(std::memory_order_seq_cst)) {
+			tail.notify_one();
+		}
+		return true;
+	}
+
+	bool try_pop(Value& value) {
+		auto position = head.load(std::memory_order_relaxed);
+		if (position == tail_cache) {
+			tail_cache = tail.load(std::memory_order_acquire);
+			if (position == tail_cache) {
+				return false;
+			}
+		}
+		value = slots[position % capacity];
+		head.store(position + 1, std::memory_order_seq_cst);
+		if (producer_parked.load(std::memory_order_seq_cst)) {
+			head.notify_one();
+		}
+		return true;
+	}
+
+	// Blocking variants, for the producer and the consumer respectively.
+	void push(Value value) {
+		while (!try_push(value)) {
+			wait_for_room();
+		}
+	}
+
+	Value pop() {
+		Value value = 0;
+		while (!try_pop(value)) {
+			wait_for_data();
+		}
+		return value;
+	}
+
+	// Values waiting in the ring, exact only when both sides are idle.
+	std::size_t size() const {
+		return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+	}
+
+private:
+	void wait_for_room();
+	void wait_for_data();
+
+	// Consumer side.
+	alignas(64) std::atomic<uint64_t> head = 0;
+	uint64_t tail_cache = 0;
+	std::atomic<bool> consumer_parked = false;
+	// Producer side.
+	alignas(64) std::atomic<uint64_t> tail = 0;
+	uint64_t head_cache = 0;
+	std::atomic<bool> producer_parked = false;
+	alignas(64) Value slots[capacity] = {};
+};
+
+} // intcode
@@ -0,0 +1,242 @@
+#include <cstdint>
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "checkpoint.hpp"
+
+namespace intcode {
+
+namespace {
+
+constexpr char magic[4] = {'I', 'C', 'C', 'P'};
+// Also tells checkpoints written with the other byte order apart.
+constexpr uint32_t version = 2;
+constexpr std::size_t frame_bytes = PagedMemory::page_size * sizeof(Value);
+// Ids size the dense index table of the program loaded.
+constexpr uint64_t max_id = uint64_t{1} << 20;
+
+struct Header {
+	char magic[4];
+	uint32_t version;
+	uint64_t computers;
+	uint64_t routes;
+	uint64_t frames;
+	// From the start of the checkpoint, a multiple of `frame_bytes`.
+	uint64_t frames_offset;
+};
+
+// Followed by the input values, the output values and a PageEntry per page.
+struct Machine {
+	uint64_t id;
+	int64_t ip;
+	int64_t base;
+	uint64_t size;
+	uint64_t inputs;
+	uint64_t outputs;
+	uint64_t pages;
+};
+
+struct PageEntry {
+	uint64_t page;
+	uint64_t frame;
+};
+
+// After the machines.
+struct Route {
+	uint64_t from;
+	uint64_t to;
+};
+
+template<typename T>
+void put(std::ostream& os, const T* values, std::size_t count) {
+	os.write(reinterpret_cast<const char*>(values), static_cast<std::streamsize>(count * sizeof(T)));
+}
+
+template<typename T>
+void get(std::istream& is, T* values, std::size_t count) {
+	if (!is.read(reinterpret_cast<char*>(values), static_cast<std::streamsize>(count * sizeof(T)))) {
+		throw std::runtime_error("intcode: truncated checkpoint");
+	}
+}
+
+// Queues are deques, written value by value.
+void put(std::ostream& os, const Data& values) {
+	for (auto value : values) {
+		put(os, &value, 1);
+	}
+}
+
+// Grown value by value, so a count past the end of a stream that cannot
+// tell its length fails on the read rather than on allocating.
+void get(std::istream& is, Data& values, uint64_t count) {
+	for (uint64_t i = 0; i < count; i++) {
+		Value value;
+		get(is, &value, 1);
+		values.push_back(value);
+	}
+}
+
+// Bytes left in `is`, as many as could be asked for when it cannot seek.
+uint64_t get_remaining(std::istream& is) {
+	auto position = is.tellg();
+	if (position == std::istream::pos_type(-1) || !is.seekg(0, std::ios::end)) {
+		is.clear();
+		return std::numeric_limits<uint64_t>::max();
+	}
+	auto end = is.tellg();
+	is.seekg(position);
+	return static_cast<uint64_t>(end - position);
+}
+
+// Takes `count` records of `size` bytes out of the bytes left, before
+// anything is allocated for them.
+void reserve(uint64_t& remaining, uint64_t count, std::size_t size) {
+	if (count > remaining / size) {
+		throw std::runtime_error("intcode: malformed checkpoint");
+	}
+	remaining -= count * size;
+}
+
+} // namespace
+
+void save_checkpoint(const Program& program, std::ostream& os) {
+	std::vector<std::tuple<Machine, Snapshot, std::vector<PageEntry>>> machines;
+	std::map<const Value*, uint64_t> numbers;
+	std::vector<const Value*> frames;
+	auto offset = sizeof(Header);
+	for (std::size_t index = 0; index < program.size(); index++) {
+		auto state = program[index].snapshot();
+		std::vector<PageEntry> pages;
+		for (auto [page, frame] : state.memory.get_frames()) {
+			auto [number, added] = numbers.emplace(frame, frames.size());
+			if (added) {
+				frames.push_back(frame);
+			}
+			pages.push_back({page, number->second});
+		}
+		Machine machine = {program.get_id(index), state.ip, state.base, state.memory.size(),
+			state.input.size(), state.output.size(), pages.size()};
+		offset += sizeof(Machine) + (state.input.size() + state.output.size()) * sizeof(Value) +
+			pages.size() * sizeof(PageEntry);
+		machines.emplace_back(machine, std::move(state), std::move(pages));
+	}
+	std::vector<Route> routes;
+	for (auto [from, to] : program.get_connections()) {
+		routes.push_back({from, to});
+	}
+	offset += routes.size() * sizeof(Route);
+
+	Header header = {{magic[0], magic[1], magic[2], magic[3]}, version, machines.size(), routes.size(),
+		frames.size(), (offset + frame_bytes - 1) / frame_bytes * frame_bytes};
+	put(os, &header, 1);
+	for (const auto& [machine, state, pages] : machines) {
+		put(os, &machine, 1);
+		put(os, state.input);
+		put(os, state.output);
+		put(os, pages.data(), pages.size());
+	}
+	put(os, routes.data(), routes.size());
+	std::vector<char> padding(header.frames_offset - offset);
+	put(os, padding.data(), padding.size());
+	// Straight from the pages, which the snapshots keep from changing.
+	for (auto frame : frames) {
+		put(os, frame, PagedMemory::page_size);
+	}
+	if (!os) {
+		throw std::runtime_error("intcode: could not write checkpoint");
+	}
+}
+
+Program load_checkpoint(std::istream& is) {
+	Header header;
+	get(is, &header, 1);
+	if (!std::equal(std::begin(magic), std::end(magic), header.magic)) {
+		throw std::runtime_error("intcode: not a checkpoint");
+	}
+	if (header.version != version) {
+		throw std::runtime_error("intcode: unsupported checkpoint version " + std::to_string(header.version));
+	}
+
+	// Counts are checked against the bytes left before they size anything.
+	auto remaining = get_remaining(is);
+	reserve(remaining, header.frames, frame_bytes);
+	reserve(remaining, header.computers, sizeof(Machine));
+	reserve(remaining, header.routes, sizeof(Route));
+
+	std::vector<std::pair<Machine, Snapshot>> machines;
+	// By number, as mapped by the first computer using each.
+	std::map<uint64_t, Value*> frames;
+	auto offset = sizeof(Header);
+	for (uint64_t i = 0; i < header.computers; i++) {
+		Machine machine;
+		get(is, &machine, 1);
+		if (machine.id >= max_id) {
+			throw std::runtime_error("intcode: malformed checkpoint");
+		}
+		reserve(remaining, machine.inputs, sizeof(Value));
+		reserve(remaining, machine.outputs, sizeof(Value));
+		reserve(remaining, machine.pages, sizeof(PageEntry));
+		Snapshot state = {{}, {}, {}, machine.base, machine.ip};
+		get(is, state.input, machine.inputs);
+		get(is, state.output, machine.outputs);
+		// The first computer mapping a frame allocates it, the others share it.
+		for (uint64_t j = 0; j < machine.pages; j++) {
+			PageEntry entry;
+			get(is, &entry, 1);
+			if (entry.frame >= header.frames) {
+				throw std::runtime_error("intcode: malformed checkpoint");
+			}
+			auto& frame = frames[entry.frame];
+			frame = state.memory.map_frame(entry.page, frame);
+		}
+		state.memory.set_size(machine.size);
+		offset += sizeof(Machine) + (machine.inputs + machine.outputs) * sizeof(Value) +
+			machine.pages * sizeof(PageEntry);
+		machines.emplace_back(machine, std::move(state));
+	}
+	std::vector<Route> routes;
+	for (uint64_t i = 0; i < header.routes; i++) {
+		Route route;
+		get(is, &route, 1);
+		routes.push_back(route);
+	}
+	offset += routes.size() * sizeof(Route);
+
+	if (header.frames_offset < offset || header.frames_offset - offset > remaining ||
+		!is.ignore(static_cast<std::streamsize>(header.frames_offset - offset))) {
+		throw std::runtime_error("intcode: malformed checkpoint");
+	}
+	// Numbers are below `header.frames`, so all of them must be mapped.
+	if (frames.size() != header.frames) {
+		throw std::runtime_error("intcode: malformed checkpoint");
+	}
+	// Read in place, no computer having run on them yet.
+	for (auto [number, frame] : frames) {
+		get(is, frame, PagedMemory::page_size);
+	}
+
+	Program program;
+	for (const auto& [machine, state] : machines) {
+		if (program.contains(machine.id)) {
+			throw std::runtime_error("intcode: malformed checkpoint");
+		}
+		program.emplace(machine.id, state);
+	}
+	for (auto [from, to] : routes) {
+		if (!program.contains(from) || !program.contains(to)) {
+			throw std::runtime_error("intcode: malformed checkpoint");
+		}
+		program.connect(from, to);
+	}
+	program.link();
+	return program;
+}
+
+} // intcode
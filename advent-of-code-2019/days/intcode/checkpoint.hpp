@@ -0,0 +1,22 @@
+#pragma once
+
+#include <istream>
+#include <ostream>
+
+#include "intcode.hpp"
+
+namespace intcode {
+
+// Binary checkpoints of a whole program, to resume it in another process.
+//
+// A checkpoint holds, per computer, its id, instruction pointer, relative
+// base, memory size, pending input and output and the pages it maps, then
+// the routes between computers. All fields are fixed-width native-endian
+// words, and the page values come last, each page on its own 4 KiB
+// boundary, so the file can be mapped as it is. Pages computers share are
+// stored once and shared again on load.
+void save_checkpoint(const Program& program, std::ostream& os);
+// Throws std::runtime_error on files it cannot read.
+Program load_checkpoint(std::istream& is);
+
+} // intcode
@@ -0,0 +1,86 @@
+#include <algorithm>
+
+#include "compiled.hpp"
+
+namespace intcode {
+
+namespace {
+
+// Cells a program may differ by from its translation, e.g. patched inputs.
+constexpr std::size_t max_differences = 16;
+
+std::vector<Translation>& get_translations() {
+	static std::vector<Translation> translations;
+	return translations;
+}
+
+bool matches(const PagedMemory& memory, const Translation& translation) {
+	if (memory.size() != translation.size) {
+		return false;
+	}
+	std::size_t differences = 0;
+	for (std::size_t cell = 0; cell < translation.size; cell++) {
+		if (memory[cell] != translation.image[cell] && ++differences > max_differences) {
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace
+
+bool register_translation(const Translation& translation) {
+	get_translations().push_back(translation);
+	return true;
+}
+
+Compiled::Compiled(CPU& cpu, const Translation& translation) :
+	translation(translation),
+	alive(translation.size, 0) {
+	for (std::size_t cell = 0; cell < translation.size; cell++) {
+		auto owner = translation.owners[cell];
+		if (owner == static_cast<Value>(cell)) {
+			alive[cell] = 1;
+		}
+	}
+	// Instructions the loaded program changed are left to the interpreter.
+	for (std::size_t cell = 0; cell < translation.size; cell++) {
+		auto owner = translation.owners[cell];
+		if (owner >= 0 && cpu.memory[cell] != translation.image[cell]) {
+			alive[static_cast<std::size_t>(owner)] = 0;
+		}
+		if (owner >= 0) {
+			cpu.code.watch_cell(static_cast<Value>(cell));
+		}
+	}
+	cpu.code.track_modified = true;
+}
+
+std::unique_ptr<Compiled> Compiled::find(CPU& cpu, const std::vector<Type>& hooked) {
+	auto translated = [](Type type) {
+		return type != Type::INPUT && type != Type::OUTPUT && type != Type::STOP;
+	};
+	if (std::any_of(hooked.begin(), hooked.end(), translated)) {
+		return nullptr;
+	}
+	for (const auto& translation : get_translations()) {
+		if (matches(cpu.memory, translation)) {
+			return std::make_unique<Compiled>(cpu, translation);
+		}
+	}
+	return nullptr;
+}
+
+void Compiled::run(CPU& cpu) {
+	for (auto location : cpu.code.modified) {
+		auto cell = static_cast<std::size_t>(location);
+		if (cell < translation.size && translation.owners[cell] >= 0) {
+			alive[static_cast<std::size_t>(translation.owners[cell])] = 0;
+		}
+	}
+	cpu.code.modified.clear();
+	compiled::Frame frame = {cpu, alive.data(), translation.owners, translation.size};
+	cpu.ip = translation.run(frame, cpu.ip);
+}
+
+} // intcode
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <memory>
+#include <vector>
+
+#include "intcode.hpp"
+
+namespace intcode {
+
+namespace compiled {
+
+// Execution state handed to translated code.
+struct Frame {
+	CPU& cpu;
+	uint8_t* alive;
+	const Value* owners;
+	std::size_t size;
+};
+
+inline Value load(Frame& frame, Value location) {
+	frame.cpu.check_address(location);
+	return frame.cpu.memory[location];
+}
+
+// Returns true when the write landed in translated code, which is then
+// left to the interpreter.
+inline bool store(Frame& frame, Value location, Value value) {
+	frame.cpu.check_address(location);
+	frame.cpu.memory.set(location, value);
+	if (frame.cpu.code.watches(location)) {
+		frame.cpu.code.invalidate(location);
+	}
+	auto cell = static_cast<std::size_t>(location);
+	if (cell < frame.size && frame.owners[cell] >= 0) {
+		frame.alive[frame.owners[cell]] = 0;
+		return true;
+	}
+	return false;
+}
+
+} // compiled
+
+// Program translated to C++ ahead of time by intcode-transpile.
+struct Translation {
+	const char* name;
+	const Value* image;
+	std::size_t size;
+	// Start of the translated instruction reading each cell, -1 for data
+	// and for operands the program patches itself.
+	const Value* owners;
+	// Runs from `ip` until an instruction has to be interpreted.
+	Value (*run)(compiled::Frame& frame, Value ip);
+};
+
+bool register_translation(const Translation& translation);
+
+// Translated code matching the program loaded in a CPU.
+class Compiled {
+public:
+	Compiled(CPU& cpu, const Translation& translation);
+
+	// Finds a translation of the loaded program, unless hooks need to see
+	// opcodes the translation executes itself.
+	static std::unique_ptr<Compiled> find(CPU& cpu, const std::vector<Type>& hooked = {});
+
+	// Runs translated code from cpu.ip for as long as possible.
+	void run(CPU& cpu);
+
+	const Translation& translation;
+
+private:
+	std::vector<uint8_t> alive;
+};
+
+} // intcode
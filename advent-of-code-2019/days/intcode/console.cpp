@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include "console.hpp"
+
+namespace intcode {
+
+namespace {
+
+// Room for a value written as a number and its newline.
+constexpr std::size_t number_size = 24;
+
+} // namespace
+
+Console::Console(int input_fd, int output_fd, std::size_t buffer_size) :
+	input_fd(input_fd),
+	output_fd(output_fd),
+	in(buffer_size),
+	out(std::max(buffer_size, number_size)) {}
+
+// Best effort: errors only surface through explicit flushes.
+Console::~Console() {
+	try {
+		flush();
+	} catch (const std::exception&) {
+	}
+}
+
+Event Console::run(Computer& comp) {
+	auto& cpu = comp.cpu;
+	// Fused pairs would hide INPUT and OUTPUT from the loop below. Records
+	// cached by an earlier run under another set are dropped here, or an
+	// OUTPUT fused after a BASE would still go to `cpu.output`.
+	cpu.code.keep_unfused({Type::INPUT, Type::OUTPUT});
+	for (;;) {
+		const auto op = cpu.code.fetch(cpu.memory, cpu.ip);
+		switch (op.opcode) {
+		case Type::OUTPUT:
+			put(op.read(cpu, 0));
+			cpu.ip += op.length;
+			break;
+		case Type::INPUT:
+			if (!cpu.input.empty()) {
+				op.execute(cpu);
+				break;
+			}
+			if (next == end) {
+				flush();
+				if (!fill()) {
+					return Event::INPUT;
+				}
+			}
+			op.write(cpu, 0, static_cast<unsigned char>(in[next++]));
+			cpu.ip += op.length;
+			break;
+		case Type::STOP:
+			flush();
+			return Event::HALTED;
+		default:
+			op.execute(cpu);
+			break;
+		}
+		cpu.code.dispatches++;
+	}
+}
+
+void Console::put(Value value) {
+	if (out.size() - pending < number_size) {
+		flush();
+	}
+	if (value >= 0 && value < 128) {
+		out[pending++] = static_cast<char>(value);
+		return;
+	}
+	auto [last, error] = std::to_chars(out.data() + pending, out.data() + out.size(), value);
+	pending = static_cast<std::size_t>(last - out.data());
+	out[pending++] = '\n';
+}
+
+void Console::flush() {
+	std::size_t written = 0;
+	while (written < pending) {
+		auto count = ::write(output_fd, out.data() + written, pending - written);
+		writes++;
+		if (count < 0 && errno == EINTR) {
+			continue;
+		}
+		if (count <= 0) {
+			pending = 0;
+			throw std::runtime_error("intcode: console output failed");
+		}
+		written += static_cast<std::size_t>(count);
+	}
+	pending = 0;
+}
+
+// Takes whatever the input has ready, up to a whole buffer, so interactive
+// use still sees every line as it is typed.
+bool Console::fill() {
+	for (;;) {
+		auto count = ::read(input_fd, in.data(), in.size());
+		reads++;
+		if (count < 0 && errno == EINTR) {
+			continue;
+		}
+		if (count <= 0) {
+			return false;
+		}
+		next = 0;
+		end = static_cast<std::size_t>(count);
+		return true;
+	}
+}
+
+} // intcode
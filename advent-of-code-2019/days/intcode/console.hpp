@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "intcode.hpp"
+
+namespace intcode {
+
+// Connects a computer speaking ASCII to file descriptors, such as standard
+// input and output. INPUT reads one byte per value; OUTPUT writes values
+// below 128 as bytes and any other as a decimal number on its own line, the
+// way ASCII programs report their answers. Both sides go through large
+// buffers, and output is only written when the program waits for input,
+// fills the buffer or halts, so long transcripts cost few system calls.
+class Console {
+public:
+	Console(int input_fd, int output_fd, std::size_t buffer_size = 1 << 16);
+	~Console();
+	Console(const Console&) = delete;
+	Console& operator=(const Console&) = delete;
+
+	// Runs on the decoded interpreter until the program halts, returning
+	// HALTED, or waits for input after the input ended, returning INPUT.
+	// Values already in the CPU input are read before the input bytes.
+	// Throws std::runtime_error when the output cannot be written.
+	Event run(Computer& comp);
+	void flush();
+
+	// System calls made on each side.
+	uint64_t reads = 0;
+	uint64_t writes = 0;
+
+private:
+	bool fill();
+	void put(Value value);
+
+	int input_fd;
+	int output_fd;
+	// Bytes `[next, end)` of `in` not read yet.
+	std::vector<char> in;
+	std::size_t next = 0;
+	std::size_t end = 0;
+	std::vector<char> out;
+	std::size_t pending = 0;
+};
+
+} // intcode
@@ -0,0 +1,341 @@
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#include "intcode.hpp"
+
+namespace intcode {
+
+namespace {
+
+// Rewrites of an operand cell after which it is treated as patched.
+constexpr uint8_t patch_threshold = 2;
+
+// Widest record: a comparison and the opcode and condition of its branch.
+constexpr Value max_span = 6;
+
+Value combine_checked(Type opcode, Value a, Value b) {
+	Value result;
+	auto overflow = opcode == Type::ADD ?
+		__builtin_add_overflow(a, b, &result) : __builtin_mul_overflow(a, b, &result);
+	if (overflow) {
+		throw std::overflow_error("intcode: " + get_operation_name(opcode) + " overflows 64 bits");
+	}
+	return result;
+}
+
+} // namespace
+
+uint8_t get_operation_length(Type opcode) {
+	switch (opcode) {
+	case Type::ADD:
+	case Type::MULTIPLY:
+	case Type::LT:
+	case Type::EQ:
+		return 4;
+	case Type::JNZ:
+	case Type::JZ:
+		return 3;
+	case Type::INPUT:
+	case Type::OUTPUT:
+	case Type::BASE:
+		return 2;
+	case Type::STOP:
+		return 1;
+	default:
+		break;
+	}
+	return 0;
+}
+
+std::string get_operation_name(Type opcode) {
+	switch (opcode) {
+	case Type::ADD: return "ADD";
+	case Type::MULTIPLY: return "MULTIPLY";
+	case Type::INPUT: return "INPUT";
+	case Type::OUTPUT: return "OUTPUT";
+	case Type::JNZ: return "JNZ";
+	case Type::JZ: return "JZ";
+	case Type::LT: return "LT";
+	case Type::EQ: return "EQ";
+	case Type::BASE: return "BASE";
+	case Type::STOP: return "STOP";
+	default: return std::to_string(static_cast<int>(opcode));
+	}
+}
+
+Value Operation::read(CPU& cpu, int parameter_id) const {
+	Value position = 0;
+	switch (static_cast<Parameter::Mode>(modes[parameter_id])) {
+	case Parameter::Mode::IMMEDIATE:
+		return operands[parameter_id];
+	case Parameter::Mode::POSITION:
+		position = operands[parameter_id];
+		break;
+	case Parameter::Mode::RELATIVE:
+		position = cpu.base + operands[parameter_id];
+		break;
+	default:
+		break;
+	}
+	cpu.check_address(position);
+#if defined(INTCODE_PROFILE)
+	if (cpu.profiler) {
+		cpu.profiler->read(position);
+	}
+#endif
+	return cpu.memory[position];
+}
+
+bool Operation::write(CPU& cpu, int parameter_id, Value value) const {
+	Value position = operands[parameter_id];
+	if (static_cast<Parameter::Mode>(modes[parameter_id]) == Parameter::Mode::RELATIVE) {
+		position += cpu.base;
+	}
+	cpu.check_address(position);
+#if defined(INTCODE_PROFILE)
+	if (cpu.profiler) {
+		cpu.profiler->write(position);
+	}
+#endif
+	cpu.memory.set(position, value);
+	if (cpu.code.watches(position)) {
+		cpu.code.invalidate(position);
+		return true;
+	}
+	return false;
+}
+
+void Operation::compare(CPU& cpu, bool result) const {
+	auto next = cpu.ip + length;
+	cpu.ip = next;
+	// The fused branch is only trusted while the store left code alone.
+	if (write(cpu, 2, result ? 1 : 0) || fusion != Fusion::COMPARE_BRANCH) {
+		return;
+	}
+	const auto branch = cpu.code.fetch(cpu.memory, next);
+	cpu.code.fused++;
+	if (result == (branch.opcode == Type::JNZ)) {
+		cpu.ip = branch.read(cpu, 1);
+	} else {
+		cpu.ip = next + branch.length;
+	}
+}
+
+void Operation::execute(CPU& cpu) const {
+#if defined(INTCODE_PROFILE)
+	if (cpu.profiler) {
+		cpu.profiler->step(cpu.ip, *this);
+	}
+#endif
+	auto next = cpu.ip + length;
+	switch (opcode) {
+	case Type::ADD: {
+		auto a = read(cpu, 0);
+		auto b = read(cpu, 1);
+		write(cpu, 2, cpu.code.checked ? combine_checked(opcode, a, b) : a + b);
+		break;
+	}
+	case Type::MULTIPLY: {
+		auto a = read(cpu, 0);
+		auto b = read(cpu, 1);
+		write(cpu, 2, cpu.code.checked ? combine_checked(opcode, a, b) : a * b);
+		break;
+	}
+	case Type::INPUT:
+		write(cpu, 0, cpu.input.front());
+		cpu.input.pop_front();
+		break;
+	case Type::OUTPUT:
+		cpu.output.push_back(read(cpu, 0));
+		break;
+	case Type::JNZ:
+		if (read(cpu, 0) != 0) {
+			next = read(cpu, 1);
+		}
+		break;
+	case Type::JZ:
+		if (read(cpu, 0) == 0) {
+			next = read(cpu, 1);
+		}
+		break;
+	case Type::LT:
+		compare(cpu, read(cpu, 0) < read(cpu, 1));
+		return;
+	case Type::EQ:
+		compare(cpu, read(cpu, 0) == read(cpu, 1));
+		return;
+	case Type::BASE:
+		cpu.base += read(cpu, 0);
+		if (fusion == Fusion::BASE_PREFIX) {
+			cpu.ip = next;
+			cpu.code.fused++;
+			const auto following = cpu.code.fetch(cpu.memory, next);
+			following.execute(cpu);
+			return;
+		}
+		break;
+	case Type::STOP:
+		next = cpu.ip;
+		break;
+	default:
+		break;
+	}
+	cpu.ip = next;
+}
+
+void Code::keep_unfused(const std::vector<Type>& opcodes) {
+	bool kept[256] = {};
+	for (auto opcode : opcodes) {
+		kept[static_cast<uint8_t>(opcode)] = true;
+	}
+	if (std::equal(std::begin(kept), std::end(kept), std::begin(unfused))) {
+		return;
+	}
+	std::copy(std::begin(kept), std::end(kept), std::begin(unfused));
+	// Records cached so far may have fused what is now kept apart.
+	reset();
+}
+
+const uint8_t* Code::watch_map(std::size_t size) {
+	if (watch.size() < size) {
+		watch.resize(size, 0);
+		rewrites.resize(size, 0);
+		patched.resize(size, 0);
+	}
+	return watch.data();
+}
+
+void Code::watch_cell(Value location) {
+	auto cell = static_cast<std::size_t>(location);
+	watch_map(cell + 1);
+	if (!patched[cell]) {
+		watch[cell] = 1;
+	}
+}
+
+void Code::invalidate(Value location) {
+	if (track_modified) {
+		modified.push_back(location);
+	}
+	for (auto ip = location - max_span + 1; ip <= location; ip++) {
+		auto slot = static_cast<std::size_t>(ip);
+		if (ip < 0 || slot >= operations.size()) {
+			continue;
+		}
+		if (auto& op = operations[slot]; op.length && ip + op.span > location) {
+			auto operand = ip < location && ip + op.length > location;
+			op.length = 0;
+			invalidations++;
+			auto cell = static_cast<std::size_t>(location);
+			if (operand && ++rewrites[cell] == patch_threshold) {
+				patched[cell] = 1;
+				watch[cell] = 0;
+			}
+		}
+	}
+}
+
+void Code::reset() {
+	operations.clear();
+	watch.clear();
+	rewrites.clear();
+	patched.clear();
+	modified.clear();
+	track_modified = false;
+}
+
+const Operation& Code::decode(const PagedMemory& memory, Value ip) {
+	auto first_operand = memory.at(static_cast<Memory::size_type>(ip));
+	auto opcode = static_cast<Type>(first_operand % 100);
+	auto length = get_operation_length(opcode);
+	if (!length) {
+		throw std::runtime_error("intcode: invalid opcode " + std::to_string(first_operand) +
+			" at " + std::to_string(ip));
+	}
+	auto modes = first_operand / 100;
+	Operation op = {};
+	op.opcode = opcode;
+	op.length = length;
+	for (int i = 0; i < length - 1; i++) {
+		op.operands[i] = memory.at(static_cast<Memory::size_type>(ip + 1 + i));
+		op.modes[i] = static_cast<uint8_t>(modes % 10);
+		modes /= 10;
+	}
+	op.fusion = get_fusion(memory, ip, op);
+	switch (op.fusion) {
+	case Fusion::COMPARE_BRANCH:
+		op.span = length + 2;
+		break;
+	case Fusion::BASE_PREFIX:
+		op.span = length + 1;
+		break;
+	default:
+		op.span = length;
+		break;
+	}
+
+	// Only code within the dense pages is cached; code at far addresses is
+	// decoded afresh each time.
+	auto slot = static_cast<std::size_t>(ip);
+	auto dense = memory.dense_size();
+	if (operations.size() < dense) {
+		operations.resize(dense);
+	}
+	watch_map(dense);
+	bool cacheable = slot + op.span <= dense;
+	for (std::size_t cell = slot; cell < std::min(slot + op.span, dense); cell++) {
+		if (patched[cell]) {
+			cacheable = false;
+		} else {
+			watch[cell] = 1;
+		}
+	}
+	decodes++;
+	if (!cacheable) {
+		return scratch = op;
+	}
+	return operations[slot] = op;
+}
+
+// Peeks at the instruction following `op` without decoding it, as it may
+// still be data the operation is about to overwrite.
+Fusion Code::get_fusion(const PagedMemory& memory, Value ip, const Operation& op) const {
+	auto after = static_cast<std::size_t>(ip + op.length);
+	if (!fusion || unfused[static_cast<uint8_t>(op.opcode)] || after >= memory.size()) {
+		return Fusion::NONE;
+	}
+	auto following = static_cast<Type>(memory[after] % 100);
+	auto length = get_operation_length(following);
+	if (!length || unfused[static_cast<uint8_t>(following)] || is_patched(after)) {
+		return Fusion::NONE;
+	}
+	auto mode = static_cast<Parameter::Mode>(memory[after] / 100 % 10);
+	switch (op.opcode) {
+	case Type::LT:
+	case Type::EQ: {
+		if ((following != Type::JNZ && following != Type::JZ) || after + 1 >= memory.size() ||
+				memory[after + 1] != op.operands[2] || is_patched(after + 1)) {
+			return Fusion::NONE;
+		}
+		// Stores in immediate mode go to the position named by the operand.
+		auto stored = static_cast<Parameter::Mode>(op.modes[2]);
+		auto relative = stored == Parameter::Mode::RELATIVE;
+		if (mode == Parameter::Mode::IMMEDIATE || relative != (mode == Parameter::Mode::RELATIVE)) {
+			return Fusion::NONE;
+		}
+		return Fusion::COMPARE_BRANCH;
+	}
+	case Type::BASE:
+		if (following == Type::BASE || following == Type::STOP) {
+			return Fusion::NONE;
+		}
+		return Fusion::BASE_PREFIX;
+	default:
+		break;
+	}
+	return Fusion::NONE;
+}
+
+} // intcode
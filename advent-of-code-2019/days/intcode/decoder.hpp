@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+#include <vector>
+
+#include "paged_memory.hpp"
+
+namespace intcode {
+
+// Forward declarations.
+class CPU;
+enum class Type : uint8_t;
+
+// Instruction sequences executed as a single superinstruction.
+enum class Fusion : uint8_t {
+	NONE,
+	// LT or EQ followed by JNZ or JZ testing the stored result.
+	COMPARE_BRANCH,
+	// BASE followed by any other instruction, as in call and return sequences.
+	BASE_PREFIX,
+};
+
+// Cells taken by an instruction, 0 for invalid opcodes.
+uint8_t get_operation_length(Type opcode);
+// Mnemonic, or the number of invalid opcodes.
+std::string get_operation_name(Type opcode);
+
+// Fixed-size, pre-decoded instruction record.
+struct Operation {
+	Value operands[3];
+	Type opcode;
+	Fusion fusion;
+	uint8_t length;
+	// Cells the record depends on, including those of a fused instruction.
+	uint8_t span;
+	uint8_t modes[3];
+
+	// Executes the operation on the CPU and advances its instruction pointer.
+	void execute(CPU& cpu) const;
+	Value read(CPU& cpu, int parameter_id) const;
+	// Returns true when the write landed in decoded code.
+	bool write(CPU& cpu, int parameter_id, Value value) const;
+
+private:
+	void compare(CPU& cpu, bool result) const;
+};
+
+static_assert(sizeof(Operation) == 32);
+
+// Decoded program cache, one record slot per memory cell.
+class Code {
+public:
+	const Operation& fetch(const PagedMemory& memory, Value ip) {
+		auto location = static_cast<std::size_t>(ip);
+		if (location < operations.size() && operations[location].length) {
+			return operations[location];
+		}
+		return decode(memory, ip);
+	}
+
+	bool watches(Value location) const {
+		auto cell = static_cast<std::size_t>(location);
+		return cell < watch.size() && watch[cell];
+	}
+
+	// Operand cells the program keeps rewriting, typically to index arrays.
+	// Records using them are decoded on every fetch instead of cached.
+	bool is_patched(Value location) const {
+		auto cell = static_cast<std::size_t>(location);
+		return cell < patched.size() && patched[cell];
+	}
+
+	// Opcodes kept out of superinstructions, as hooks have to see them.
+	// Changing the set drops the cached records.
+	void keep_unfused(const std::vector<Type>& opcodes);
+	// Watch map covering at least `size` cells, for translated code.
+	const uint8_t* watch_map(std::size_t size);
+	// Reports writes to a cell decoded elsewhere through `modified`.
+	void watch_cell(Value location);
+	void invalidate(Value location);
+	void reset();
+
+	uint64_t decodes = 0;
+	uint64_t invalidations = 0;
+	// Records dispatched by the interpreter and instructions executed as
+	// the tail of a superinstruction.
+	uint64_t dispatches = 0;
+	uint64_t fused = 0;
+	// Cells written after being decoded, kept for tiers built on top of
+	// the records while `track_modified` is set. `reset()` clears both.
+	bool track_modified = false;
+	// Whether decoding fuses instruction sequences into superinstructions.
+	bool fusion = true;
+	// Whether ADD and MULTIPLY throw std::overflow_error instead of wrapping
+	// around. Checked runs stay on the interpreter.
+	bool checked = false;
+	std::vector<Value> modified;
+
+private:
+	const Operation& decode(const PagedMemory& memory, Value ip);
+	Fusion get_fusion(const PagedMemory& memory, Value ip, const Operation& op) const;
+
+	std::vector<Operation> operations;
+	std::vector<uint8_t> watch;
+	std::vector<uint8_t> rewrites;
+	std::vector<uint8_t> patched;
+	Operation scratch = {};
+	bool unfused[256] = {};
+};
+
+} // intcode
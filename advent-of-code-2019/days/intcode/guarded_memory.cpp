@@ -0,0 +1,243 @@
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "guarded_memory.hpp"
+
+#if defined(__unix__)
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+
+#include <signal.h>
+#include <sys/mman.h>
+
+namespace intcode {
+
+namespace {
+
+// Ranges the fault handler commits chunks in, read from the handler
+// without locks. A slot is free while `begin` is 0.
+struct Slot {
+	std::atomic<uintptr_t> begin{0};
+	std::atomic<uintptr_t> end{0};
+	std::atomic<uint64_t> faults{0};
+};
+
+constexpr std::size_t slot_count = 256;
+
+Slot slots[slot_count];
+std::mutex slots_mutex;
+std::once_flag installed;
+struct sigaction previous;
+
+void handle_fault(int signal, siginfo_t* info, void* context) {
+	auto address = reinterpret_cast<uintptr_t>(info->si_addr);
+	for (auto& slot : slots) {
+		auto begin = slot.begin.load(std::memory_order_acquire);
+		auto end = slot.end.load(std::memory_order_acquire);
+		if (!begin || address < begin || address >= end) {
+			continue;
+		}
+		auto chunk = begin + (address - begin) / GuardedMemory::chunk_bytes * GuardedMemory::chunk_bytes;
+		auto length = std::min(chunk + GuardedMemory::chunk_bytes, end) - chunk;
+		if (mprotect(reinterpret_cast<void*>(chunk), length, PROT_READ | PROT_WRITE) == 0) {
+			slot.faults.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		break;
+	}
+	// Not a guarded memory: the faulting access runs again under the
+	// handler installed before, or the default action.
+	if (previous.sa_flags & SA_SIGINFO) {
+		previous.sa_sigaction(signal, info, context);
+	} else if (previous.sa_handler != SIG_DFL && previous.sa_handler != SIG_IGN) {
+		previous.sa_handler(signal);
+	} else {
+		::signal(SIGSEGV, SIG_DFL);
+	}
+}
+
+void install() {
+	struct sigaction action = {};
+	action.sa_sigaction = handle_fault;
+	action.sa_flags = SA_SIGINFO;
+	sigemptyset(&action.sa_mask);
+	if (sigaction(SIGSEGV, &action, &previous) != 0) {
+		throw std::runtime_error("intcode: cannot install the guarded memory handler");
+	}
+}
+
+} // namespace
+
+GuardedMemory::GuardedMemory(const Memory& image, std::size_t capacity) :
+	cells(capacity) {
+	if (image.size() > capacity) {
+		throw std::length_error("intcode: program of " + std::to_string(image.size()) +
+			" cells does not fit in guarded memory");
+	}
+	std::call_once(installed, install);
+	reserved = cells * sizeof(Value) + chunk_bytes;
+	auto* range = mmap(nullptr, reserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (range == MAP_FAILED) {
+		throw std::runtime_error("intcode: cannot reserve " + std::to_string(reserved) + " bytes");
+	}
+	values = static_cast<Value*>(range);
+	// The image is committed up front rather than one fault per chunk.
+	auto loaded = (image.size() * sizeof(Value) + chunk_bytes - 1) / chunk_bytes * chunk_bytes;
+	if (loaded) {
+		mprotect(values, loaded, PROT_READ | PROT_WRITE);
+		std::memcpy(values, image.data(), image.size() * sizeof(Value));
+	}
+
+	std::lock_guard lock(slots_mutex);
+	for (slot = 0; slot < slot_count; slot++) {
+		if (!slots[slot].begin.load(std::memory_order_relaxed)) {
+			break;
+		}
+	}
+	if (slot == slot_count) {
+		munmap(values, reserved);
+		throw std::runtime_error("intcode: too many guarded memories");
+	}
+	auto begin = reinterpret_cast<uintptr_t>(values);
+	slots[slot].faults.store(0, std::memory_order_relaxed);
+	slots[slot].end.store(begin + reserved, std::memory_order_release);
+	slots[slot].begin.store(begin, std::memory_order_release);
+}
+
+GuardedMemory::~GuardedMemory() {
+	{
+		std::lock_guard lock(slots_mutex);
+		slots[slot].begin.store(0, std::memory_order_release);
+	}
+	munmap(values, reserved);
+}
+
+bool GuardedMemory::available() {
+	return true;
+}
+
+uint64_t GuardedMemory::faults() const {
+	return slots[slot].faults.load(std::memory_order_relaxed);
+}
+
+} // intcode
+
+#else
+
+namespace intcode {
+
+GuardedMemory::GuardedMemory(const Memory& /*image*/, std::size_t /*capacity*/) {
+	throw std::runtime_error("intcode: guarded memory needs mmap");
+}
+
+GuardedMemory::~GuardedMemory() {}
+
+bool GuardedMemory::available() {
+	return false;
+}
+
+uint64_t GuardedMemory::faults() const {
+	return 0;
+}
+
+} // intcode
+
+#endif
+
+namespace intcode {
+
+namespace {
+
+constexpr Value mode_scale[] = {1, 10, 100};
+
+} // namespace
+
+GuardedComputer::GuardedComputer(const Memory& image, Data initial_input, std::size_t capacity) :
+	memory(image, capacity),
+	input(std::move(initial_input)) {}
+
+Event GuardedComputer::run(std::size_t outputs) {
+	for (;;) {
+		if (outputs && output.size() >= outputs) {
+			return Event::OUTPUT;
+		}
+		auto* cells = &locate(ip);
+		auto instruction = cells[0];
+		auto modes = instruction / 100;
+		auto mode = [&](int parameter) {
+			return static_cast<Parameter::Mode>(modes / mode_scale[parameter - 1] % 10);
+		};
+		auto read = [&](int parameter) -> Value {
+			switch (mode(parameter)) {
+			case Parameter::Mode::IMMEDIATE:
+				return cells[parameter];
+			case Parameter::Mode::RELATIVE:
+				return locate(base + cells[parameter]);
+			default:
+				return locate(cells[parameter]);
+			}
+		};
+		auto write = [&](int parameter) -> Value& {
+			if (mode(parameter) == Parameter::Mode::RELATIVE) {
+				return locate(base + cells[parameter]);
+			}
+			return locate(cells[parameter]);
+		};
+		switch (static_cast<Type>(instruction % 100)) {
+		case Type::ADD:
+			write(3) = read(1) + read(2);
+			ip += 4;
+			break;
+		case Type::MULTIPLY:
+			write(3) = read(1) * read(2);
+			ip += 4;
+			break;
+		case Type::INPUT:
+			if (input.empty()) {
+				return Event::INPUT;
+			}
+			write(1) = input.front();
+			input.pop_front();
+			ip += 2;
+			break;
+		case Type::OUTPUT:
+			output.push_back(read(1));
+			ip += 2;
+			break;
+		case Type::JNZ:
+			ip = read(1) != 0 ? read(2) : ip + 3;
+			break;
+		case Type::JZ:
+			ip = read(1) == 0 ? read(2) : ip + 3;
+			break;
+		case Type::LT:
+			write(3) = read(1) < read(2) ? 1 : 0;
+			ip += 4;
+			break;
+		case Type::EQ:
+			write(3) = read(1) == read(2) ? 1 : 0;
+			ip += 4;
+			break;
+		case Type::BASE:
+			base += read(1);
+			ip += 2;
+			break;
+		case Type::STOP:
+			return Event::HALTED;
+		default:
+			throw std::runtime_error("intcode: invalid opcode " + std::to_string(instruction) +
+				" at " + std::to_string(ip));
+		}
+		steps++;
+	}
+}
+
+void GuardedComputer::out_of_range(Value location) const {
+	throw std::out_of_range("intcode: address " + std::to_string(location) + " outside guarded memory");
+}
+
+} // intcode
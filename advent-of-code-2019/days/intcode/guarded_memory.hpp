@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "intcode.hpp"
+
+namespace intcode {
+
+// Memory reserved as one range of address space with no access rights, so
+// cells are reached by plain indexing. The first access to a chunk faults,
+// and a process-wide SIGSEGV handler commits the chunk and lets the access
+// run again; cells never written read as zero. Faults outside every guarded
+// memory go to the handler installed before.
+//
+// Unlike PagedMemory, nothing is shared between memories and there are no
+// snapshots; addresses from `capacity()` on are left to the caller.
+class GuardedMemory {
+public:
+	// 8 GiB of address space, committed a megabyte at a time.
+	static constexpr std::size_t default_capacity = std::size_t{1} << 30;
+	static constexpr std::size_t chunk_bytes = std::size_t{1} << 20;
+
+	// Throws std::runtime_error when the range cannot be reserved.
+	explicit GuardedMemory(const Memory& image, std::size_t capacity = default_capacity);
+	~GuardedMemory();
+	GuardedMemory(const GuardedMemory&) = delete;
+	GuardedMemory& operator=(const GuardedMemory&) = delete;
+
+	// Whether the platform can guard memory.
+	static bool available();
+
+	// Cells that can be addressed. The reservation runs a chunk further, so
+	// instructions starting before `capacity()` can be read whole.
+	std::size_t capacity() const {
+		return cells;
+	}
+
+	Value operator[](std::size_t location) const {
+		return values[location];
+	}
+
+	Value& operator[](std::size_t location) {
+		return values[location];
+	}
+
+	// Chunks committed by faults.
+	uint64_t faults() const;
+
+private:
+	Value* values = nullptr;
+	std::size_t cells = 0;
+	std::size_t reserved = 0;
+	std::size_t slot = 0;
+};
+
+// Decodes and runs instructions straight from a guarded memory. Only an
+// address past the reserved range costs a check, one unsigned comparison
+// that also catches negative addresses; memory never grows in software.
+class GuardedComputer {
+public:
+	GuardedComputer(const Memory& image, Data initial_input, std::size_t capacity = GuardedMemory::default_capacity);
+
+	// Same contract as `Computer::run` without a budget.
+	Event run(std::size_t outputs = 0);
+
+	GuardedMemory memory;
+	Data input;
+	Data output;
+	Value base = 0;
+	Value ip = 0;
+	uint64_t steps = 0;
+
+private:
+	Value& locate(Value location) {
+		if (static_cast<uint64_t>(location) >= memory.capacity()) {
+			out_of_range(location);
+		}
+		return memory[static_cast<std::size_t>(location)];
+	}
+
+	[[noreturn]] void out_of_range(Value location) const;
+};
+
+} // intcode
@@ -1,20 +1,59 @@
-#include <thread>
-
-#include "../utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#include "compiled.hpp"
 #include "intcode.hpp"
+#include "jit.hpp"
 
 namespace intcode {
 
+namespace {
+
+std::atomic<Tier> tier = Tier::INTERPRETER;
+
+// Profiled runs stay unfused on the interpreter, so the profiler sees every
+// instruction.
+bool prepare_profile([[maybe_unused]] CPU& cpu) {
+#if defined(INTCODE_PROFILE)
+	if (cpu.profiler) {
+		if (cpu.code.fusion) {
+			cpu.code.fusion = false;
+			cpu.code.reset();
+		}
+		return true;
+	}
+#endif
+	return false;
+}
+
+// Stops recording modified cells once the tier that reads them is gone,
+// however the run ends.
+struct ModifiedTracking {
+	Code& code;
+
+	~ModifiedTracking() {
+		code.track_modified = false;
+		code.modified.clear();
+	}
+};
+
+} // namespace
+
 Parameter::Parameter(Value value, Value new_mode) :
 	value(value),
 	mode(static_cast<Parameter::Mode>(new_mode)) {}
 
-CPU::CPU(Memory& memory, Data& input, Data& output, Value base) :
-	memory(memory), input(input), output(output), base(base) {}
+CPU::CPU(PagedMemory& memory, Data& input, Data& output, Value base) :
+	memory(memory), input(input), output(output), base(base), ip(0) {}
 
-void CPU::memory_size_guard(Value location) {
-	if (location >= static_cast<Value>(memory.size())) {
-		memory.resize(location+ 1, 0);
+void CPU::check_address(Value location) {
+	if (location < 0) {
+		throw std::out_of_range("intcode: negative address " + std::to_string(location));
 	}
 }
 
@@ -40,8 +79,8 @@ Value Instruction::get_parameter_with_mode(CPU& cpu, int parameter_id) {
 	default:
 		break;
 	}
-	cpu.memory_size_guard(position);
-	return cpu.memory.at(position);
+	cpu.check_address(position);
+	return cpu.memory[position];
 }
 
 void Instruction::store_to_parameter(CPU& cpu, int parameter_id, Value value) {
@@ -57,8 +96,8 @@ void Instruction::store_to_parameter(CPU& cpu, int parameter_id, Value value) {
 	default:
 		break;
 	}
-	cpu.memory_size_guard(position);
-	cpu.memory[position] = value;
+	cpu.check_address(position);
+	cpu.memory.set(position, value);
 }
 
 Add::Add(CPU& cpu, Parameters parameters, Value ip) :
@@ -186,31 +225,118 @@ std::unique_ptr<Stop> Stop::from_source(CPU& cpu, Value modes, Value ip) {
 	return Instruction::from_source<Stop>(cpu, modes, ip, 0);
 }
 
-Computer::Computer(Memory n_memory, Data initial_input, Memory::size_type n_feed_to) :
-	memory(n_memory),
+Computer::Computer(Memory n_memory, Data initial_input) :
+	Computer(PagedMemory(n_memory), std::move(initial_input)) {}
+
+Computer::Computer(PagedMemory n_memory, Data initial_input) :
+	memory(std::move(n_memory)),
 	input(initial_input),
-	feed_to(n_feed_to),
 	cpu(memory, input, output, 0) {}
 
-void Computer::add_to_input(Value value) {
-	std::lock_guard lock(m);
-	input.push_back(value);
-	cv.notify_one();
+Computer::Computer(const Snapshot& snapshot) :
+	memory(snapshot.memory),
+	input(snapshot.input),
+	output(snapshot.output),
+	cpu(memory, input, output, snapshot.base) {
+	cpu.ip = snapshot.ip;
+}
+
+Computer::Computer(Computer&& other) :
+	memory(std::move(other.memory)),
+	input(std::move(other.input)),
+	output(std::move(other.output)),
+	cpu(memory, input, output, other.cpu.base) {
+	cpu.ip = other.cpu.ip;
+	cpu.code = std::move(other.cpu.code);
+#if defined(INTCODE_PROFILE)
+	cpu.profiler = other.cpu.profiler;
+#endif
+}
+
+Snapshot Computer::snapshot() const {
+	return {memory, input, output, cpu.base, cpu.ip};
+}
+
+// Decoded code is dropped, as the memory it was decoded from is replaced.
+void Computer::restore(const Snapshot& snapshot) {
+	memory = snapshot.memory;
+	input = snapshot.input;
+	output = snapshot.output;
+	cpu.base = snapshot.base;
+	cpu.ip = snapshot.ip;
+	cpu.code.reset();
+}
+
+Computer::RunResult Computer::run(std::size_t outputs, uint64_t budget) {
+	prepare_profile(cpu);
+	cpu.code.keep_unfused({Type::INPUT});
+	// A fused pair counts as the two instructions it runs.
+	auto executed = [&] {
+		return cpu.code.dispatches + cpu.code.fused;
+	};
+	auto limit = executed() + budget;
+	for (;;) {
+		if (outputs && output.size() >= outputs) {
+			return {Event::OUTPUT, output};
+		}
+		if (budget && executed() >= limit) {
+			return {Event::BUDGET, output};
+		}
+		const auto op = cpu.code.fetch(cpu.memory, cpu.ip);
+		if (op.opcode == Type::INPUT && input.empty()) {
+			return {Event::INPUT, output};
+		}
+		if (op.opcode == Type::STOP) {
+			return {Event::HALTED, output};
+		}
+		cpu.code.dispatches++;
+		op.execute(cpu);
+	}
 }
 
-void Computer::wait_for_input() {
-	std::unique_lock lock(m);
-	cv.wait(lock, [&] { return input.size() != 0;});
-	lock.unlock();
+Computer& Program::at(Memory::size_type id) {
+	return computers[get_index(id)];
 }
 
-Value Computer::wait_for_input_and_pop() {
-	std::unique_lock lock(m);
-	cv.wait(lock, [&] {return input.size() != 0;});
-	auto value = input.front();
-	input.pop_front();
-	lock.unlock();
-	return value;
+const Computer& Program::at(Memory::size_type id) const {
+	return computers[get_index(id)];
+}
+
+std::size_t Program::get_index(Memory::size_type id) const {
+	if (!contains(id)) {
+		throw std::out_of_range("intcode: no computer " + std::to_string(id));
+	}
+	return indices[id];
+}
+
+void Program::connect(Memory::size_type from, Memory::size_type to) {
+	connections.emplace_back(from, to);
+	offsets.clear();
+}
+
+void Program::broadcast(Memory::size_type from) {
+	for (auto to : ids) {
+		if (to != from) {
+			connect(from, to);
+		}
+	}
+}
+
+// Counting sort of the connections by source index.
+void Program::link() {
+	std::vector<std::size_t> counts(computers.size() + 1);
+	for (auto [from, to] : connections) {
+		get_index(to);
+		counts[get_index(from) + 1]++;
+	}
+	for (std::size_t i = 1; i < counts.size(); i++) {
+		counts[i] += counts[i - 1];
+	}
+	offsets = counts;
+	targets.resize(connections.size());
+	for (auto [from, to] : connections) {
+		targets[counts[get_index(from)]++] = get_index(to);
+	}
 }
 
 std::unique_ptr<Instruction> instruction_factory(CPU& cpu, Value ip) {
@@ -246,12 +372,13 @@ std::unique_ptr<Instruction> instruction_factory(CPU& cpu, Value ip) {
 
 void run_program_on_computer_with_id(Program& program, Memory::size_type id, Hooks instruction_hooks) {
 	auto& comp = program.at(id);
+	const HookTable hooks(instruction_hooks);
 	Value ip = 0;
 	for (;;) {
 		auto inst = instruction_factory(comp.cpu, ip);
 		auto opcode = inst->get_opcode();
-		if (instruction_hooks.contains(opcode)) {
-			instruction_hooks[opcode](program, comp, inst);
+		if (auto hook = hooks[opcode]) {
+			(*hook)(program, comp, inst);
 		} else {
 			inst->execute(comp.cpu);
 		}
@@ -263,21 +390,81 @@ void run_program_on_computer_with_id(Program& program, Memory::size_type id, Hoo
 	return; // Should not be reached.
 }
 
-void run_program_with_phase_settings(Program& program, Memory phase_settings, Hooks instruction_hooks) {
-	if (program.size() != phase_settings.size()) {
-		return;
+void set_tier(Tier new_tier) {
+	tier = new_tier;
+}
+
+Tier get_tier() {
+	return tier;
+}
+
+void run_decoded_program_on_computer_with_id(Program& program, Memory::size_type id, const OperationHooks& operation_hooks) {
+	auto& comp = program.at(id);
+	auto& cpu = comp.cpu;
+	cpu.ip = 0;
+	cpu.code.reset();
+	auto run_tier = prepare_profile(cpu) || cpu.code.checked ? Tier::INTERPRETER : tier.load();
+	const HookTable hooks(operation_hooks);
+	cpu.code.keep_unfused(hooks.opcodes);
+	ModifiedTracking tracking{cpu.code};
+	std::unique_ptr<Jit> jit;
+	std::unique_ptr<Compiled> compiled;
+	if (run_tier == Tier::JIT && Jit::available()) {
+		jit = std::make_unique<Jit>(hooks.opcodes);
+	} else if (run_tier == Tier::COMPILED) {
+		compiled = Compiled::find(cpu, hooks.opcodes);
 	}
-	std::vector<std::thread> threads(program.size());
-	for (Program::size_type i = 0; i < program.size(); i++) {
-		threads[i] = std::thread(
-			run_program_on_computer_with_id,
-			std::ref(program),
-			phase_settings[i],
-			instruction_hooks
-		);
+	for (;;) {
+		if (jit) {
+			jit->run(cpu);
+		} else if (compiled) {
+			compiled->run(cpu);
+		}
+		// Copied, as the execution may invalidate the cached record.
+		const auto op = cpu.code.fetch(cpu.memory, cpu.ip);
+		cpu.code.dispatches++;
+		if (auto hook = hooks[op.opcode]) {
+			(*hook)(program, comp, op);
+		} else {
+			op.execute(cpu);
+		}
+		if (op.opcode == Type::STOP) {
+			return;
+		}
 	}
-	for (Program::size_type i = 0; i < program.size(); i++) {
-		threads[i].join();
+}
+
+Status resume_decoded_program_on_computer_with_id(Program& program, Memory::size_type id) {
+	static const OperationHookTable no_hooks;
+	return resume_decoded_program_on_computer_with_id(program, id, no_hooks);
+}
+
+Status resume_decoded_program_on_computer_with_id(Program& program, Memory::size_type id, const OperationHooks& operation_hooks) {
+	return resume_decoded_program_on_computer_with_id(program, id, OperationHookTable(operation_hooks));
+}
+
+Status resume_decoded_program_on_computer_with_id(Program& program, Memory::size_type id, const OperationHookTable& hooks) {
+	auto& comp = program.at(id);
+	auto& cpu = comp.cpu;
+	prepare_profile(cpu);
+	auto unfused = hooks.opcodes;
+	unfused.push_back(Type::INPUT);
+	cpu.code.keep_unfused(unfused);
+	auto input_hook = hooks[Type::INPUT];
+	for (;;) {
+		const auto op = cpu.code.fetch(cpu.memory, cpu.ip);
+		if (op.opcode == Type::INPUT && cpu.input.empty() && !input_hook) {
+			return Status::BLOCKED;
+		}
+		cpu.code.dispatches++;
+		if (auto hook = hooks[op.opcode]) {
+			(*hook)(program, comp, op);
+		} else {
+			op.execute(cpu);
+		}
+		if (op.opcode == Type::STOP) {
+			return Status::HALTED;
+		}
 	}
 }
 
@@ -286,17 +473,14 @@ Program get_program_for_memory_with_phase_settings(const Memory& memory, const M
 	for (Memory::size_type i = 0; i < phase_settings.size(); i++) {
 		auto id = phase_settings[i];
 		auto idx = (i + 1) % phase_settings.size();
-		auto feed_to = phase_settings[idx];
 		Data initial_input = {id};
 		if (i == 0) {
 			initial_input.push_back(0);
 		}
-		program.emplace(
-			std::piecewise_construct,
-			std::make_tuple(id),
-			std::make_tuple(memory, initial_input, feed_to)
-		);
+		program.emplace(id, memory, initial_input);
+		program.connect(id, phase_settings[idx]);
 	}
+	program.link();
 	return program;
 }
 
@@ -308,23 +492,91 @@ Program get_program_for_memory_with_patched_data(const Memory& memory, const Mem
 	return get_program_for_memory_with_input_data(mem, Data());
 }
 
+Program get_program_for_memory_with_patched_data(const PagedMemory& image, const Memory& patch, int idx) {
+	auto memory = image;
+	for (const auto& val : patch) {
+		memory.set(static_cast<std::size_t>(idx++), val);
+	}
+	return get_program_for_memory_with_input_data(memory, Data());
+}
+
+Program get_program_for_memory_with_input_data(const PagedMemory& image, const Data& data) {
+	Program program;
+	program.emplace(0, image, data);
+	return program;
+}
+
 Program get_program_for_memory_with_input_data(const Memory& memory, const Data& data) {
 	Program program;
-	program.emplace(
-		std::piecewise_construct,
-		std::make_tuple(0),
-		std::make_tuple(memory, data, 0)
-	);
+	program.emplace(0, memory, data);
+	return program;
+}
+
+Program get_program_for_snapshot_with_input_data(const Snapshot& snapshot, const Data& data) {
+	Program program;
+	auto& comp = program.emplace(0, snapshot);
+	comp.cpu.input.insert(comp.cpu.input.end(), data.begin(), data.end());
 	return program;
 }
 
-Memory get_memory_from_string(const std::string& source) {
+// Single pass over the source, values separated by commas and optionally
+// surrounded by whitespace.
+Memory get_memory_from_string(std::string_view source) {
+	const char* first = source.data();
+	const char* last = first + source.size();
+	auto skip_space = [last](const char* at) {
+		return std::find_if_not(at, last, [](char c) {
+			return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+		});
+	};
+	auto error_at = [first](const char* at) {
+		return "intcode: no value at offset " + std::to_string(at - first) + " of the source";
+	};
+
 	Memory memory;
-	auto partially_parsed = split_string_by(source, ",");
-	for (const auto& elem : partially_parsed) {
-		memory.push_back(std::stoll(elem));
+	memory.reserve(static_cast<std::size_t>(std::count(first, last, ',')) + 1);
+	for (auto at = first;; at++) {
+		at = skip_space(at);
+		if (at != last && *at == '+') {
+			at++;
+		}
+		Value value = 0;
+		auto [end, error] = std::from_chars(at, last, value);
+		if (error == std::errc::result_out_of_range) {
+			throw std::out_of_range(error_at(at));
+		} else if (error != std::errc()) {
+			throw std::invalid_argument(error_at(at));
+		}
+		memory.push_back(value);
+		at = skip_space(end);
+		if (at == last) {
+			return memory;
+		}
+		if (*at != ',') {
+			throw std::invalid_argument(error_at(at));
+		}
+	}
+}
+
+const PagedMemory& get_image_from_string(std::string_view source) {
+	struct Image {
+		std::string source;
+		PagedMemory memory;
+	};
+	static std::mutex m;
+	static std::unordered_multimap<std::size_t, Image> images;
+
+	auto hash = std::hash<std::string_view>()(source);
+	std::lock_guard lock(m);
+	auto [first, last] = images.equal_range(hash);
+	for (auto image = first; image != last; image++) {
+		if (image->second.source == source) {
+			return image->second.memory;
+		}
 	}
-	return memory;
+	// Parsed under the lock, so a source is never parsed twice.
+	auto memory = PagedMemory(get_memory_from_string(source));
+	return images.emplace(hash, Image{std::string(source), std::move(memory)})->second.memory;
 }
 
 }
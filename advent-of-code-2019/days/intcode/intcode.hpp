@@ -2,18 +2,26 @@
 
 #include <cstdint>
 
-#include <condition_variable>
+#include <array>
 #include <deque>
 #include <functional>
+#include <limits>
 #include <map>
 #include <memory>
-#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
+#include "decoder.hpp"
+#include "profiler.hpp"
+
 namespace intcode {
 
 // Supported instruction types.
-enum class Type {
+enum class Type : uint8_t {
 	ADD = 1,
 	MULTIPLY = 2,
 	INPUT = 3,
@@ -26,11 +34,38 @@ enum class Type {
 	STOP = 99,
 };
 
+// Reason a resumable run gave control back.
+enum class Status {
+	// Waiting at an INPUT instruction for a value.
+	BLOCKED,
+	HALTED,
+};
+
+// Why `Computer::run` returned.
+enum class Event {
+	// Waiting at an INPUT instruction for a value.
+	INPUT,
+	// As many outputs as asked for are pending.
+	OUTPUT,
+	HALTED,
+	// The instruction budget ran out.
+	BUDGET,
+};
+
+// Execution tiers of the decoded engine.
+enum class Tier {
+	INTERPRETER,
+	JIT,
+	// Translated ahead of time by intcode-transpile, when available.
+	COMPILED,
+};
+
 // Forward declarations.
 class Computer;
 class CPU;
 class Instruction;
 class Parameter;
+class Program;
 
 // Types definitions.
 using Value = int64_t;
@@ -38,8 +73,36 @@ using Data = std::deque<Value>;
 using Memory = std::vector<Value>;
 using Parameters = std::vector<Parameter>;
 using Pointer = Memory::iterator;
-using Program = std::map<Memory::size_type, Computer>;
 using Hooks = std::map<Type, std::function<void(Program&, Computer&, std::unique_ptr<Instruction>&)>>;
+using OperationHooks = std::map<Type, std::function<void(Program&, Computer&, const Operation&)>>;
+
+// Hooks resolved into a table indexed by opcode before a run starts, so
+// opcodes without hooks cost one load instead of a map lookup. Points into
+// the hooks it was built from.
+template<typename Hook>
+class HookTable {
+public:
+	// No hooks.
+	HookTable() = default;
+	explicit HookTable(const std::map<Type, Hook>& hooks) {
+		for (const auto& [opcode, hook] : hooks) {
+			table[static_cast<uint8_t>(opcode)] = &hook;
+			opcodes.push_back(opcode);
+		}
+	}
+
+	const Hook* operator[](Type opcode) const {
+		return table[static_cast<uint8_t>(opcode)];
+	}
+
+	// Opcodes having a hook.
+	std::vector<Type> opcodes;
+
+private:
+	std::array<const Hook*, 256> table = {};
+};
+
+using OperationHookTable = HookTable<OperationHooks::mapped_type>;
 
 // Instruction parameters.
 class Parameter {
@@ -61,14 +124,22 @@ public:
 // Central processing unit.
 class CPU {
 public:
-	CPU(Memory& memory, Data& input, Data& output, Value base);
+	CPU(PagedMemory& memory, Data& input, Data& output, Value base);
 	~CPU() = default;
-	void memory_size_guard(Value location);
+	// Throws on addresses no memory can hold; any other reads as zero until
+	// written.
+	void check_address(Value location);
 
-	Memory& memory;
+	PagedMemory& memory;
 	Data& input;
 	Data& output;
 	Value base;
+	Value ip;
+	Code code;
+#if defined(INTCODE_PROFILE)
+	// Set to profile the decoded interpreter.
+	Profiler* profiler = nullptr;
+#endif
 };
 
 // Generic instruction.
@@ -206,32 +277,158 @@ public:
 	static std::unique_ptr<Stop> from_source(CPU& cpu, Value modes, Value ip);
 };
 
-class Computer {
+// Execution state of a computer. Its memory pages stay shared with the
+// computer it was taken from until either side writes them.
+struct Snapshot {
+	PagedMemory memory;
+	Data input;
+	Data output;
+	Value base;
+	Value ip;
+};
+
+// Aligned to a cache line, so neighbours in a Program run by different
+// workers never write to the same line.
+class alignas(64) Computer {
 public:
-	Computer(Memory memory, Data initial_input, Memory::size_type feed_to);
+	Computer(Memory memory, Data initial_input);
+	Computer(PagedMemory memory, Data initial_input);
+	// Forks a computer continuing from a snapshot.
+	explicit Computer(const Snapshot& snapshot);
+	Computer(Computer&& other);
 
 public:
-	void add_to_input(Value value);
-	void wait_for_input();
-	Value wait_for_input_and_pop();
+	Snapshot snapshot() const;
+	void restore(const Snapshot& snapshot);
+
+public:
+	struct RunResult {
+		Event event;
+		// Outputs not taken yet, oldest first.
+		Data& output;
+	};
+	// Runs on the decoded interpreter until INPUT finds no value, `outputs`
+	// values are pending, the program halts or `budget` instructions ran,
+	// 0 meaning no limit. Drivers take the outputs and feed `cpu.input`.
+	RunResult run(std::size_t outputs = 0, uint64_t budget = 0);
 
 private:
-	Memory memory;
+	PagedMemory memory;
 	Data input;
 	Data output;
-	std::mutex m;
-	std::condition_variable cv;
 public:
-	Memory::size_type feed_to;
 	CPU cpu;
 };
 
+// Computers of a network, stored contiguously in the order added and
+// addressed by small integer ids, such as Day 7's phase settings. Outputs
+// travel along routes, which may fan out to many computers or merge from
+// many into one; `link` resolves them once into an adjacency table.
+class Program {
+public:
+	// Adds a computer built from `args` under an id not taken yet. Adding
+	// computers moves the others, invalidating references to them.
+	template<typename... Args>
+	Computer& emplace(Memory::size_type id, Args&&... args) {
+		if (contains(id)) {
+			throw std::invalid_argument("intcode: computer " + std::to_string(id) + " added twice");
+		}
+		if (id >= indices.size()) {
+			indices.resize(id + 1, none);
+		}
+		indices[id] = computers.size();
+		ids.push_back(id);
+		offsets.clear();
+		return computers.emplace_back(std::forward<Args>(args)...);
+	}
+
+	bool contains(Memory::size_type id) const {
+		return id < indices.size() && indices[id] != none;
+	}
+	// Throws std::out_of_range for ids not taken.
+	Computer& at(Memory::size_type id);
+	const Computer& at(Memory::size_type id) const;
+	std::size_t get_index(Memory::size_type id) const;
+	Memory::size_type get_id(std::size_t index) const {
+		return ids[index];
+	}
+
+	// Computers by index, in the order added.
+	std::size_t size() const {
+		return computers.size();
+	}
+	Computer& operator[](std::size_t index) {
+		return computers[index];
+	}
+	const Computer& operator[](std::size_t index) const {
+		return computers[index];
+	}
+	auto begin() {
+		return computers.begin();
+	}
+	auto end() {
+		return computers.end();
+	}
+	auto begin() const {
+		return computers.begin();
+	}
+	auto end() const {
+		return computers.end();
+	}
+
+	// Routes the outputs of `from` to `to` too.
+	void connect(Memory::size_type from, Memory::size_type to);
+	// Routes the outputs of `from` to every other computer added so far.
+	void broadcast(Memory::size_type from);
+	// Routes by id, in the order connected.
+	const std::vector<std::pair<Memory::size_type, Memory::size_type>>& get_connections() const {
+		return connections;
+	}
+	// Resolves the routes into indices. Throws std::out_of_range for routes
+	// to or from computers not added.
+	void link();
+	// Indices of the computers fed by the one at `index`, once linked.
+	std::span<const std::size_t> get_routes(std::size_t index) const {
+		if (offsets.empty()) {
+			throw std::logic_error("intcode: routes read before linking");
+		}
+		return {targets.data() + offsets[index], targets.data() + offsets[index + 1]};
+	}
+
+private:
+	static constexpr std::size_t none = std::numeric_limits<std::size_t>::max();
+
+	std::vector<Computer> computers;
+	std::vector<Memory::size_type> ids;
+	// Index of each id, `none` for ids not taken.
+	std::vector<std::size_t> indices;
+	std::vector<std::pair<Memory::size_type, Memory::size_type>> connections;
+	// Computer `i` feeds `targets[offsets[i]]` up to `targets[offsets[i + 1]]`,
+	// `offsets` being empty until linked.
+	std::vector<std::size_t> offsets;
+	std::vector<std::size_t> targets;
+};
+
 // Code execution.
+void set_tier(Tier tier);
+Tier get_tier();
 void run_program_on_computer_with_id(Program& program, Memory::size_type id, Hooks instruction_hooks = {});
-void run_program_with_phase_settings(Program& program, Memory phase_settings, Hooks instruction_hooks = {});
+void run_decoded_program_on_computer_with_id(Program& program, Memory::size_type id, const OperationHooks& operation_hooks = {});
+// Runs from the current instruction pointer until INPUT finds no value
+// (unless hooked) or the program stops, on the decoded interpreter.
+Status resume_decoded_program_on_computer_with_id(Program& program, Memory::size_type id);
+Status resume_decoded_program_on_computer_with_id(Program& program, Memory::size_type id, const OperationHooks& operation_hooks);
+Status resume_decoded_program_on_computer_with_id(Program& program, Memory::size_type id, const OperationHookTable& hooks);
 Program get_program_for_memory_with_phase_settings(const Memory& memory, const Memory& phase_settings);
 Program get_program_for_memory_with_patched_data(const Memory& memory, const Memory& patch, int idx = 1);
 Program get_program_for_memory_with_input_data(const Memory& memory, const Data& data);
-Memory get_memory_from_string(const std::string& source);
+// Computers built from a cached image share its pages until they write.
+Program get_program_for_memory_with_patched_data(const PagedMemory& image, const Memory& patch, int idx = 1);
+Program get_program_for_memory_with_input_data(const PagedMemory& image, const Data& data);
+Program get_program_for_snapshot_with_input_data(const Snapshot& snapshot, const Data& data);
+Memory get_memory_from_string(std::string_view source);
+// Parses each distinct source once per process; the image returned lives
+// until exit and is never written.
+const PagedMemory& get_image_from_string(std::string_view source);
 
 } // intcode
@@ -0,0 +1,715 @@
+#include "intcode.hpp"
+#include "jit.hpp"
+
+#if defined(__x86_64__) && defined(__unix__)
+
+#include <cstddef>
+#include <cstring>
+
+#include <algorithm>
+#include <limits>
+#include <new>
+#include <stdexcept>
+
+#include <sys/mman.h>
+
+namespace intcode {
+
+namespace {
+
+constexpr std::size_t buffer_size = 4 << 20;
+constexpr int max_block_length = 64;
+constexpr Value max_block_span = max_block_length * 4;
+constexpr uint16_t hot = 2;
+constexpr uint16_t never = std::numeric_limits<uint16_t>::max();
+constexpr uint16_t max_translations = 8;
+
+// Reasons for translated code to return to the interpreter.
+enum Status : uint32_t {
+	MISS = 0,
+	INTERPRET = 1,
+	MODIFIED = 2,
+};
+
+// State shared with translated code, offsets are baked into the stubs.
+struct Context {
+	Value* const* pages;
+	uint64_t size;
+	const uint8_t* watch;
+	const void* const* table;
+	Value base;
+	Value ip;
+	Value location;
+	// Cells below both `size` and `memory.size()`; stores from here on grow
+	// memory, so they are left to the interpreter.
+	uint64_t length;
+};
+
+static_assert(offsetof(Context, pages) == 0);
+static_assert(offsetof(Context, size) == 8);
+static_assert(offsetof(Context, watch) == 16);
+static_assert(offsetof(Context, table) == 24);
+static_assert(offsetof(Context, base) == 32);
+static_assert(offsetof(Context, ip) == 40);
+static_assert(offsetof(Context, location) == 48);
+static_assert(offsetof(Context, length) == 56);
+
+using Entry = Status(*)(Context*, const void*);
+
+enum Reg : uint8_t {
+	RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7,
+	R8 = 8, R9 = 9, R10 = 10, R11 = 11, R12 = 12, R13 = 13, R14 = 14, R15 = 15,
+};
+
+// Registers pinned while translated code runs.
+constexpr Reg CONTEXT = RBP;
+constexpr Reg PAGES = RBX;
+constexpr Reg SIZE = R12;
+constexpr Reg BASE = R13;
+constexpr Reg WATCH = R14;
+constexpr Reg TABLE = R15;
+
+enum Condition : uint8_t {
+	BELOW = 0x2,
+	ABOVE_EQUAL = 0x3,
+	EQUAL = 0x4,
+	NOT_EQUAL = 0x5,
+	LESS = 0xC,
+};
+
+bool fits_int32(Value value) {
+	return value >= std::numeric_limits<int32_t>::min() && value <= std::numeric_limits<int32_t>::max();
+}
+
+// Minimal x86-64 encoder for the instructions used by the translator.
+class Assembler {
+public:
+	Assembler(uint8_t* origin) : origin(origin) {}
+
+	std::size_t size() const { return bytes.size(); }
+	const uint8_t* here() const { return origin + bytes.size(); }
+
+	void emit(uint8_t byte) { bytes.push_back(byte); }
+
+	void emit32(uint32_t value) {
+		for (int i = 0; i < 4; i++) {
+			emit(static_cast<uint8_t>(value >> (8 * i)));
+		}
+	}
+
+	void emit64(uint64_t value) {
+		for (int i = 0; i < 8; i++) {
+			emit(static_cast<uint8_t>(value >> (8 * i)));
+		}
+	}
+
+	void rex(bool wide, uint8_t reg, uint8_t index, uint8_t base) {
+		uint8_t prefix = static_cast<uint8_t>(0x40 | (wide << 3) | ((reg >> 3) << 2) | ((index >> 3) << 1) | (base >> 3));
+		if (prefix != 0x40) {
+			emit(prefix);
+		}
+	}
+
+	void modrm(uint8_t mod, uint8_t reg, uint8_t rm) {
+		emit(static_cast<uint8_t>((mod << 6) | ((reg & 7) << 3) | (rm & 7)));
+	}
+
+	// reg <-> [base + disp32]
+	void memory_operand(uint8_t opcode, Reg reg, Reg base, int32_t disp) {
+		rex(true, reg, 0, base);
+		emit(opcode);
+		modrm(2, reg, base);
+		if ((base & 7) == RSP) {
+			emit(0x24);
+		}
+		emit32(static_cast<uint32_t>(disp));
+	}
+
+	// reg <-> [base + index * 8], base must not be RBP or R13.
+	void indexed_operand(uint8_t opcode, Reg reg, Reg base, Reg index) {
+		rex(true, reg, index, base);
+		emit(opcode);
+		modrm(0, reg, RSP);
+		emit(static_cast<uint8_t>((3 << 6) | ((index & 7) << 3) | (base & 7)));
+	}
+
+	void load(Reg dst, Reg base, int32_t disp) { memory_operand(0x8B, dst, base, disp); }
+	void store(Reg base, int32_t disp, Reg src) { memory_operand(0x89, src, base, disp); }
+	void load_indexed(Reg dst, Reg base, Reg index) { indexed_operand(0x8B, dst, base, index); }
+	void store_indexed(Reg base, Reg index, Reg src) { indexed_operand(0x89, src, base, index); }
+	void lea(Reg dst, Reg base, int32_t disp) { memory_operand(0x8D, dst, base, disp); }
+
+	void mov(Reg dst, Value value) {
+		if (fits_int32(value)) {
+			rex(true, 0, 0, dst);
+			emit(0xC7);
+			modrm(3, 0, dst);
+			emit32(static_cast<uint32_t>(value));
+		} else {
+			rex(true, 0, 0, dst);
+			emit(static_cast<uint8_t>(0xB8 | (dst & 7)));
+			emit64(static_cast<uint64_t>(value));
+		}
+	}
+
+	// Two register arithmetic of the `op rm, reg` form.
+	void arithmetic(uint8_t opcode, Reg dst, Reg src) {
+		rex(true, src, 0, dst);
+		emit(opcode);
+		modrm(3, src, dst);
+	}
+
+	void add(Reg dst, Reg src) { arithmetic(0x01, dst, src); }
+	void cmp(Reg lhs, Reg rhs) { arithmetic(0x39, lhs, rhs); }
+	void cmp(Reg lhs, Reg base, int32_t disp) { memory_operand(0x3B, lhs, base, disp); }
+	void test(Reg lhs, Reg rhs) { arithmetic(0x85, lhs, rhs); }
+	void mov(Reg dst, Reg src) { arithmetic(0x89, dst, src); }
+
+	void shift_right(Reg reg, uint8_t bits) {
+		rex(true, 0, 0, reg);
+		emit(0xC1);
+		modrm(3, 5, reg);
+		emit(bits);
+	}
+
+	void mask(Reg reg, int32_t bits) {
+		rex(true, 0, 0, reg);
+		emit(0x81);
+		modrm(3, 4, reg);
+		emit32(static_cast<uint32_t>(bits));
+	}
+
+	void imul(Reg dst, Reg src) {
+		rex(true, dst, 0, src);
+		emit(0x0F);
+		emit(0xAF);
+		modrm(3, dst, src);
+	}
+
+	// eax = condition ? 1 : 0
+	void set(Condition condition) {
+		emit(0x0F);
+		emit(static_cast<uint8_t>(0x90 | condition));
+		emit(0xC0);
+		emit(0x0F);
+		emit(0xB6);
+		emit(0xC0);
+	}
+
+	// cmp byte [base + index], 0
+	void check_byte(Reg base, Reg index) {
+		rex(false, 0, index, base);
+		emit(0x80);
+		modrm(0, 7, RSP);
+		emit(static_cast<uint8_t>(((index & 7) << 3) | (base & 7)));
+		emit(0);
+	}
+
+	// cmp dword [frame - 8], 1: the reference count in front of a page.
+	void check_shared(Reg frame) {
+		rex(false, 0, 0, frame);
+		emit(0x83);
+		modrm(1, 7, frame);
+		if ((frame & 7) == RSP) {
+			emit(0x24);
+		}
+		emit(static_cast<uint8_t>(-8));
+		emit(1);
+	}
+
+	// cmp byte [base + disp32], 0
+	void check_byte(Reg base, int32_t disp) {
+		rex(false, 0, 0, base);
+		emit(0x80);
+		modrm(2, 7, base);
+		emit32(static_cast<uint32_t>(disp));
+		emit(0);
+	}
+
+	void status(Status value) {
+		emit(0xBA);
+		emit32(value);
+	}
+
+	void push(Reg reg) {
+		rex(false, 0, 0, reg);
+		emit(static_cast<uint8_t>(0x50 | (reg & 7)));
+	}
+
+	void pop(Reg reg) {
+		rex(false, 0, 0, reg);
+		emit(static_cast<uint8_t>(0x58 | (reg & 7)));
+	}
+
+	void ret() { emit(0xC3); }
+
+	void jump(Reg target) {
+		rex(false, 0, 0, target);
+		emit(0xFF);
+		modrm(3, 4, target);
+	}
+
+	// Jumps return the offset of their rel32 field for later patching.
+	std::size_t jump(const uint8_t* target) {
+		emit(0xE9);
+		return relative(target);
+	}
+
+	std::size_t jump(Condition condition, const uint8_t* target = nullptr) {
+		emit(0x0F);
+		emit(static_cast<uint8_t>(0x80 | condition));
+		return relative(target);
+	}
+
+	void patch(std::size_t field) {
+		auto displacement = static_cast<int32_t>(size() - (field + 4));
+		std::memcpy(&bytes[field], &displacement, 4);
+	}
+
+	std::vector<uint8_t> bytes;
+
+private:
+	std::size_t relative(const uint8_t* target) {
+		auto field = size();
+		auto displacement = target ? static_cast<int32_t>(target - (here() + 4)) : 0;
+		emit32(static_cast<uint32_t>(displacement));
+		return field;
+	}
+
+	uint8_t* origin;
+};
+
+// Exit stubs collected while translating and emitted after the block.
+struct Exit {
+	std::size_t field;
+	Status status;
+	Value ip;
+	bool known_location;
+	Value location;
+};
+
+class Translator {
+public:
+	Translator(Assembler& as, const uint8_t* dispatch, const uint8_t* leave, uint64_t size, uint64_t length) :
+		as(as), dispatch(dispatch), leave(leave), size(size), length(length) {}
+
+	// Loads an operand into `reg`, leaving at `ip` when it would grow memory.
+	// Patched operands are read from their cell when executed.
+	void load(Reg reg, const Operation& op, int i, Value ip, bool patched) {
+		auto value = op.operands[i];
+		auto mode = static_cast<Parameter::Mode>(op.modes[i]);
+		if (patched) {
+			load_cell(reg, ip + 1 + i);
+			if (mode == Parameter::Mode::IMMEDIATE) {
+				return;
+			}
+			if (mode == Parameter::Mode::RELATIVE) {
+				as.add(reg, BASE);
+			}
+		} else if (mode == Parameter::Mode::IMMEDIATE) {
+			as.mov(reg, value);
+			return;
+		} else if (mode == Parameter::Mode::RELATIVE) {
+			relative_address(reg, value);
+		} else if (is_known(value)) {
+			load_cell(reg, value);
+			return;
+		} else {
+			as.mov(reg, value);
+		}
+		interpret_unless_below_size(reg, ip);
+		// reg = pages[reg >> page_bits][reg & page_mask]
+		as.mov(R8, reg);
+		as.shift_right(R8, PagedMemory::page_bits);
+		as.load_indexed(R8, PAGES, R8);
+		as.mask(reg, PagedMemory::page_mask);
+		as.load_indexed(reg, R8, reg);
+	}
+
+	// Stores RAX, leaving at `next` when the write lands in decoded code and
+	// at `ip` when the page is shared and has to be copied first or when the
+	// write grows memory. Memory only grows, so a constant address below the
+	// length at translation stays below it.
+	void store(const Operation& op, int i, Value ip, Value next, bool patched) {
+		auto value = op.operands[i];
+		auto relative = static_cast<Parameter::Mode>(op.modes[i]) == Parameter::Mode::RELATIVE;
+		if (!patched && !relative && is_known(value) && static_cast<uint64_t>(value) < length) {
+			as.load(R8, PAGES, static_cast<int32_t>((value >> PagedMemory::page_bits) * 8));
+			interpret_if_shared(ip);
+			as.store(R8, static_cast<int32_t>((value & PagedMemory::page_mask) * 8), RAX);
+			as.check_byte(WATCH, static_cast<int32_t>(value));
+			exits.push_back({as.jump(NOT_EQUAL), MODIFIED, next, true, value});
+			return;
+		}
+		if (patched) {
+			load_cell(RCX, ip + 1 + i);
+			if (relative) {
+				as.add(RCX, BASE);
+			}
+		} else if (relative) {
+			relative_address(RCX, value);
+		} else {
+			as.mov(RCX, value);
+		}
+		interpret_unless_below_length(RCX, ip);
+		as.mov(R8, RCX);
+		as.shift_right(R8, PagedMemory::page_bits);
+		as.load_indexed(R8, PAGES, R8);
+		interpret_if_shared(ip);
+		as.mov(R9, RCX);
+		as.mask(R9, PagedMemory::page_mask);
+		as.store_indexed(R8, R9, RAX);
+		as.check_byte(WATCH, RCX);
+		exits.push_back({as.jump(NOT_EQUAL), MODIFIED, next, false, 0});
+	}
+
+	// Continues at the instruction pointer held in RAX.
+	void jump_to_rax() {
+		as.jump(dispatch);
+	}
+
+	void jump_to(Value ip) {
+		as.mov(RAX, ip);
+		jump_to_rax();
+	}
+
+	void interpret(Value ip) {
+		as.mov(RAX, ip);
+		as.status(INTERPRET);
+		as.jump(leave);
+	}
+
+	void emit_exits() {
+		for (const auto& exit : exits) {
+			as.patch(exit.field);
+			if (exit.status == MODIFIED) {
+				if (exit.known_location) {
+					as.mov(RCX, exit.location);
+				}
+				as.store(CONTEXT, offsetof(Context, location), RCX);
+			}
+			as.mov(RAX, exit.ip);
+			as.status(exit.status);
+			as.jump(leave);
+		}
+	}
+
+private:
+	bool is_known(Value address) const {
+		return address >= 0 && static_cast<uint64_t>(address) < size && fits_int32(address * 8);
+	}
+
+	void relative_address(Reg reg, Value offset) {
+		if (fits_int32(offset)) {
+			as.lea(reg, BASE, static_cast<int32_t>(offset));
+		} else {
+			as.mov(reg, offset);
+			as.add(reg, BASE);
+		}
+	}
+
+	void load_cell(Reg reg, Value cell) {
+		as.load(reg, PAGES, static_cast<int32_t>((cell >> PagedMemory::page_bits) * 8));
+		as.load(reg, reg, static_cast<int32_t>((cell & PagedMemory::page_mask) * 8));
+	}
+
+	// Expects the page frame in R8.
+	void interpret_if_shared(Value ip) {
+		as.check_shared(R8);
+		exits.push_back({as.jump(NOT_EQUAL), INTERPRET, ip, false, 0});
+	}
+
+	void interpret_unless_below_size(Reg reg, Value ip) {
+		as.cmp(reg, SIZE);
+		exits.push_back({as.jump(ABOVE_EQUAL), INTERPRET, ip, false, 0});
+	}
+
+	void interpret_unless_below_length(Reg reg, Value ip) {
+		as.cmp(reg, CONTEXT, offsetof(Context, length));
+		exits.push_back({as.jump(ABOVE_EQUAL), INTERPRET, ip, false, 0});
+	}
+
+	Assembler& as;
+	const uint8_t* dispatch;
+	const uint8_t* leave;
+	uint64_t size;
+	uint64_t length;
+	std::vector<Exit> exits;
+};
+
+} // namespace
+
+Jit::Jit(const std::vector<Type>& hooked) {
+	for (auto type : hooked) {
+		interpreted[static_cast<int>(type) % 100] = true;
+	}
+	interpreted[static_cast<int>(Type::INPUT)] = true;
+	interpreted[static_cast<int>(Type::OUTPUT)] = true;
+	interpreted[static_cast<int>(Type::STOP)] = true;
+
+	auto pages = mmap(nullptr, buffer_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (pages == MAP_FAILED) {
+		throw std::bad_alloc();
+	}
+	buffer = static_cast<uint8_t*>(pages);
+
+	// enter(context, entry): pins the registers and jumps to the block.
+	Assembler as(buffer);
+	for (auto reg : {RBP, RBX, R12, R13, R14, R15}) {
+		as.push(reg);
+	}
+	as.mov(CONTEXT, RDI);
+	as.load(PAGES, CONTEXT, offsetof(Context, pages));
+	as.load(SIZE, CONTEXT, offsetof(Context, size));
+	as.load(WATCH, CONTEXT, offsetof(Context, watch));
+	as.load(TABLE, CONTEXT, offsetof(Context, table));
+	as.load(BASE, CONTEXT, offsetof(Context, base));
+	as.jump(RSI);
+
+	// leave: RAX holds the instruction pointer, EDX the status.
+	leave = as.here();
+	as.store(CONTEXT, offsetof(Context, base), BASE);
+	as.store(CONTEXT, offsetof(Context, ip), RAX);
+	as.mov(RAX, RDX);
+	for (auto reg : {R15, R14, R13, R12, RBX, RBP}) {
+		as.pop(reg);
+	}
+	as.ret();
+
+	// dispatch: continues at the block starting at RAX, if translated.
+	dispatch = as.here();
+	as.cmp(RAX, SIZE);
+	auto outside = as.jump(ABOVE_EQUAL);
+	as.load_indexed(RCX, TABLE, RAX);
+	as.test(RCX, RCX);
+	auto missing = as.jump(EQUAL);
+	as.jump(RCX);
+	as.patch(outside);
+	as.patch(missing);
+	as.status(MISS);
+	as.jump(leave);
+
+	std::memcpy(buffer, as.bytes.data(), as.size());
+	used = stubs = as.size();
+	mprotect(buffer, buffer_size, PROT_READ | PROT_EXEC);
+}
+
+Jit::~Jit() {
+	munmap(buffer, buffer_size);
+}
+
+bool Jit::available() {
+	return true;
+}
+
+void Jit::run(CPU& cpu) {
+	auto size = cpu.memory.dense_size();
+	if (table.size() < size) {
+		table.resize(size, nullptr);
+		heat.resize(size, 0);
+		churn.resize(size, 0);
+	}
+	cpu.code.track_modified = true;
+	for (auto location : cpu.code.modified) {
+		invalidate(location);
+	}
+	cpu.code.modified.clear();
+
+	auto enter = reinterpret_cast<Entry>(buffer);
+	for (;;) {
+		auto slot = static_cast<std::size_t>(cpu.ip);
+		if (slot >= size) {
+			return;
+		}
+		auto entry = table[slot];
+		if (!entry) {
+			if (heat[slot] == never || ++heat[slot] < hot) {
+				return;
+			}
+			entry = translate(cpu, cpu.ip);
+			if (!entry) {
+				heat[slot] = never;
+				return;
+			}
+		}
+		Context context = {
+			cpu.memory.page_table(),
+			size,
+			cpu.code.watch_map(size),
+			table.data(),
+			cpu.base,
+			cpu.ip,
+			0,
+			std::min<uint64_t>(cpu.memory.size(), size),
+		};
+		entries++;
+		auto status = enter(&context, entry);
+		cpu.base = context.base;
+		cpu.ip = context.ip;
+		if (status == INTERPRET) {
+			return;
+		}
+		if (status == MODIFIED) {
+			cpu.code.invalidate(context.location);
+			for (auto location : cpu.code.modified) {
+				invalidate(location);
+			}
+			cpu.code.modified.clear();
+		}
+	}
+}
+
+const void* Jit::translate(CPU& cpu, Value start) {
+	if (buffer_size - used < 64 * 1024) {
+		flush();
+	}
+	auto origin = buffer + used;
+
+	Assembler as(origin);
+	Translator translator(as, dispatch, leave, cpu.memory.dense_size(),
+		std::min<uint64_t>(cpu.memory.size(), cpu.memory.dense_size()));
+	auto ip = start;
+	int length = 0;
+	for (bool open = true; open; length++) {
+		if (length == max_block_length) {
+			translator.jump_to(ip);
+			break;
+		}
+		Operation op;
+		// Code past the dense pages is neither cached nor watched.
+		if (!fits_int32((ip + 4) * 8) || static_cast<uint64_t>(ip + 4) > cpu.memory.dense_size()) {
+			translator.interpret(ip);
+			break;
+		}
+		try {
+			op = cpu.code.fetch(cpu.memory, ip);
+		} catch (const std::exception&) {
+			if (!length) {
+				return nullptr;
+			}
+			translator.interpret(ip);
+			break;
+		}
+		if (interpreted[static_cast<int>(op.opcode) % 100]) {
+			if (!length) {
+				return nullptr;
+			}
+			translator.interpret(ip);
+			break;
+		}
+		auto next = ip + op.length;
+		bool patched[3] = {};
+		for (int i = 0; i < op.length - 1; i++) {
+			patched[i] = cpu.code.is_patched(ip + 1 + i);
+		}
+		switch (op.opcode) {
+		case Type::ADD:
+		case Type::MULTIPLY:
+		case Type::LT:
+		case Type::EQ:
+			translator.load(RAX, op, 0, ip, patched[0]);
+			translator.load(RDX, op, 1, ip, patched[1]);
+			if (op.opcode == Type::ADD) {
+				as.add(RAX, RDX);
+			} else if (op.opcode == Type::MULTIPLY) {
+				as.imul(RAX, RDX);
+			} else {
+				as.cmp(RAX, RDX);
+				as.set(op.opcode == Type::LT ? LESS : EQUAL);
+			}
+			translator.store(op, 2, ip, next, patched[2]);
+			break;
+		case Type::BASE:
+			translator.load(RAX, op, 0, ip, patched[0]);
+			as.add(BASE, RAX);
+			break;
+		case Type::JNZ:
+		case Type::JZ: {
+			auto condition = op.opcode == Type::JNZ ? EQUAL : NOT_EQUAL;
+			auto immediate = !patched[0] && static_cast<Parameter::Mode>(op.modes[0]) == Parameter::Mode::IMMEDIATE;
+			if (immediate && ((op.operands[0] != 0) == (op.opcode == Type::JZ))) {
+				// Never taken.
+				translator.jump_to(next);
+				open = false;
+				break;
+			}
+			std::size_t fall_through = 0;
+			if (!immediate) {
+				translator.load(RAX, op, 0, ip, patched[0]);
+				as.test(RAX, RAX);
+				fall_through = as.jump(condition);
+			}
+			translator.load(RAX, op, 1, ip, patched[1]);
+			translator.jump_to_rax();
+			if (!immediate) {
+				as.patch(fall_through);
+				translator.jump_to(next);
+			}
+			open = false;
+			break;
+		}
+		default:
+			translator.interpret(ip);
+			open = false;
+			break;
+		}
+		ip = next;
+	}
+	translator.emit_exits();
+
+	if (used + as.size() > buffer_size) {
+		return nullptr;
+	}
+	mprotect(buffer, buffer_size, PROT_READ | PROT_WRITE);
+	std::memcpy(origin, as.bytes.data(), as.size());
+	mprotect(buffer, buffer_size, PROT_READ | PROT_EXEC);
+	used += as.size();
+
+	auto slot = static_cast<std::size_t>(start);
+	table[slot] = origin;
+	blocks[start] = ip;
+	translations++;
+	return origin;
+}
+
+void Jit::invalidate(Value location) {
+	auto first = blocks.lower_bound(location - max_block_span);
+	while (first != blocks.end() && first->first <= location) {
+		if (first->second > location) {
+			auto slot = static_cast<std::size_t>(first->first);
+			table[slot] = nullptr;
+			// Code rewriting itself over and over stays interpreted.
+			heat[slot] = ++churn[slot] < max_translations ? 0 : never;
+			invalidations++;
+			first = blocks.erase(first);
+		} else {
+			++first;
+		}
+	}
+}
+
+void Jit::flush() {
+	std::fill(table.begin(), table.end(), nullptr);
+	blocks.clear();
+	used = stubs;
+}
+
+} // intcode
+
+#else
+
+namespace intcode {
+
+Jit::Jit(const std::vector<Type>& /*interpreted*/) {}
+
+Jit::~Jit() {}
+
+bool Jit::available() {
+	return false;
+}
+
+void Jit::run(CPU& /*cpu*/) {}
+
+} // intcode
+
+#endif
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <map>
+#include <vector>
+
+#include "decoder.hpp"
+
+namespace intcode {
+
+// Translates hot basic blocks into x86-64 machine code placed in mmap'd
+// pages. Translated code leaves for the interpreter on every instruction it
+// does not handle itself: INPUT, OUTPUT, STOP, hooked opcodes, accesses
+// that would grow memory and writes landing in decoded code.
+class Jit {
+public:
+	explicit Jit(const std::vector<Type>& interpreted = {});
+	~Jit();
+	Jit(const Jit&) = delete;
+	Jit& operator=(const Jit&) = delete;
+
+	static bool available();
+
+	// Runs translated code from cpu.ip for as long as possible.
+	void run(CPU& cpu);
+
+	uint64_t translations = 0;
+	uint64_t invalidations = 0;
+	uint64_t entries = 0;
+
+private:
+	const void* translate(CPU& cpu, Value ip);
+	void invalidate(Value location);
+	void flush();
+
+	bool interpreted[100] = {};
+	uint8_t* buffer = nullptr;
+	std::size_t used = 0;
+	std::size_t stubs = 0;
+	const uint8_t* leave = nullptr;
+	const uint8_t* dispatch = nullptr;
+	std::vector<const void*> table;
+	std::vector<uint16_t> heat;
+	std::vector<uint8_t> churn;
+	std::map<Value, Value> blocks;
+};
+
+} // intcode
@@ -0,0 +1,100 @@
+#include <mutex>
+#include <stdexcept>
+
+#include "memo.hpp"
+
+namespace intcode {
+
+namespace {
+
+std::size_t get_hash(std::size_t program, const Data& input) {
+	std::size_t hash = 0xcbf29ce484222325 ^ program;
+	for (auto value : input) {
+		hash = (hash ^ static_cast<std::size_t>(value)) * 0x100000001b3;
+	}
+	return hash;
+}
+
+struct Blocked {};
+
+} // namespace
+
+std::size_t Memo::find_program(const PagedMemory& image) {
+	{
+		std::shared_lock lock(mutex);
+		for (std::size_t program = 0; program < images.size(); program++) {
+			if (images[program] == image) {
+				return program;
+			}
+		}
+	}
+	std::unique_lock lock(mutex);
+	for (std::size_t program = 0; program < images.size(); program++) {
+		if (images[program] == image) {
+			return program;
+		}
+	}
+	images.push_back(image);
+	return images.size() - 1;
+}
+
+Data Memo::run(const PagedMemory& image, const Data& input) {
+	auto program = find_program(image);
+	auto hash = get_hash(program, input);
+	{
+		std::shared_lock lock(mutex);
+		auto [first, last] = entries.equal_range(hash);
+		for (auto entry = first; entry != last; entry++) {
+			if (entry->second.program == program && entry->second.input == input) {
+				hits.fetch_add(1, std::memory_order_relaxed);
+				return entry->second.output;
+			}
+		}
+	}
+
+	// Run outside the lock: threads missing on the same key both run it.
+	misses.fetch_add(1, std::memory_order_relaxed);
+	auto computers = get_program_for_memory_with_input_data(image, input);
+	static const OperationHooks hooks = {
+		{
+			Type::INPUT,
+			[](Program&, Computer& comp, const Operation& op) {
+				if (comp.cpu.input.empty()) {
+					throw Blocked();
+				}
+				op.execute(comp.cpu);
+			}
+		},
+	};
+	try {
+		run_decoded_program_on_computer_with_id(computers, 0, hooks);
+	} catch (const Blocked&) {
+		throw std::runtime_error("intcode: memoized program wants more input than given");
+	}
+
+	auto& output = computers.at(0).cpu.output;
+	std::unique_lock lock(mutex);
+	// Unless cleared in the meantime.
+	if (program < images.size() && images[program] == image) {
+		entries.emplace(hash, Entry{program, input, output});
+	}
+	return output;
+}
+
+std::size_t Memo::size() const {
+	std::shared_lock lock(mutex);
+	return entries.size();
+}
+
+void Memo::clear() {
+	std::unique_lock lock(mutex);
+	images.clear();
+	entries.clear();
+}
+
+Memo& get_memo() {
+	static Memo memo;
+	return memo;
+}
+
+} // intcode
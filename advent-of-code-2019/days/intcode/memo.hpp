@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "intcode.hpp"
+
+namespace intcode {
+
+// Outputs of programs run from their image on a given input, kept so runs
+// repeated with the same input cost a lookup. A program is a function of
+// its image and input alone, even when it writes over its own code, as long
+// as it halts without asking for more input than given: those are the runs
+// kept. Safe to use from several threads.
+class Memo {
+public:
+	// Outputs of `image` run on `input` until it halts, on the current tier.
+	// Throws std::runtime_error if the program wants more input.
+	Data run(const PagedMemory& image, const Data& input);
+
+	uint64_t get_hits() const {
+		return hits.load(std::memory_order_relaxed);
+	}
+	uint64_t get_misses() const {
+		return misses.load(std::memory_order_relaxed);
+	}
+	std::size_t size() const;
+	void clear();
+
+private:
+	struct Entry {
+		std::size_t program;
+		Data input;
+		Data output;
+	};
+
+	// Index of `image` in `images`, added if new.
+	std::size_t find_program(const PagedMemory& image);
+
+	mutable std::shared_mutex mutex;
+	// Copies pinning the pages of the images seen, so an image sharing them
+	// compares equal by frame, without reading its values.
+	std::vector<PagedMemory> images;
+	std::unordered_multimap<std::size_t, Entry> entries;
+	std::atomic<uint64_t> hits = 0;
+	std::atomic<uint64_t> misses = 0;
+};
+
+// Memo shared by the whole process, living until exit.
+Memo& get_memo();
+
+} // intcode
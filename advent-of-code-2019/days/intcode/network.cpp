@@ -0,0 +1,130 @@
+#include <algorithm>
+
+#include "network.hpp"
+
+namespace intcode {
+
+Network::Network(const PagedMemory& image, std::size_t size, std::size_t workers) :
+	nodes(size),
+	inboxes(size),
+	outboxes(std::max<std::size_t>(workers, 1)),
+	rendezvous(workers, [this](std::size_t worker) { work(worker); }) {
+	for (std::size_t i = 0; i < size; i++) {
+		program.emplace(i, image, Data{static_cast<Value>(i)});
+	}
+}
+
+void Network::run(const Sink& sink, const Idle& idle) {
+	for (;;) {
+		runnable.clear();
+		bool running = false;
+		for (std::size_t i = 0; i < nodes.size(); i++) {
+			auto& node = nodes[i];
+			auto& inbox = inboxes[i];
+			if (node.halted) {
+				inbox.clear();
+				continue;
+			}
+			running = true;
+			auto& input = program[i].cpu.input;
+			if (!inbox.empty()) {
+				input.insert(input.end(), inbox.begin(), inbox.end());
+				inbox.clear();
+				node.polls = 0;
+			}
+			if (!input.empty() || node.polls < patience) {
+				runnable.push_back(i);
+			}
+		}
+		if (!running) {
+			return;
+		}
+		if (runnable.empty()) {
+			idles++;
+			auto packet = idle();
+			if (!packet || !deliver(*packet, sink)) {
+				return;
+			}
+			continue;
+		}
+
+		rounds++;
+		rendezvous.run();
+		// In worker order, so delivery does not depend on the thread count.
+		for (const auto& sent : outboxes) {
+			for (const auto& packet : sent) {
+				if (!deliver(packet, sink)) {
+					return;
+				}
+			}
+		}
+	}
+}
+
+// Workers take even slices of the machines running this round.
+void Network::work(std::size_t worker) {
+	auto& sent = outboxes[worker];
+	sent.clear();
+	auto first = runnable.size() * worker / outboxes.size();
+	auto end = runnable.size() * (worker + 1) / outboxes.size();
+	for (auto i = first; i < end; i++) {
+		run_machine(runnable[i], sent);
+	}
+}
+
+void Network::run_machine(std::size_t index, std::vector<Packet>& sent) {
+	auto& comp = program[index];
+	auto& node = nodes[index];
+	auto polled = comp.cpu.input.empty();
+	if (polled) {
+		comp.cpu.input.push_back(-1);
+	}
+	auto before = sent.size();
+	auto status = resume_decoded_program_on_computer_with_id(program, program.get_id(index));
+	// Packets split across rounds wait in the output.
+	auto& output = comp.cpu.output;
+	while (output.size() >= 3) {
+		sent.push_back({output[0], output[1], output[2]});
+		output.erase(output.begin(), output.begin() + 3);
+	}
+	node.halted = status == Status::HALTED;
+	node.polls = polled && sent.size() == before ? node.polls + 1 : 0;
+}
+
+bool Network::deliver(const Packet& packet, const Sink& sink) {
+	packets++;
+	if (packet.address >= 0 && static_cast<std::size_t>(packet.address) < nodes.size()) {
+		auto& inbox = inboxes[static_cast<std::size_t>(packet.address)];
+		inbox.push_back(packet.x);
+		inbox.push_back(packet.y);
+		return true;
+	}
+	return sink(packet);
+}
+
+void Nat::run(Network& network) {
+	network.run(
+		[&](const Network::Packet& packet) {
+			if (packet.address == address) {
+				if (!first_y) {
+					first_y = packet.y;
+				}
+				last = packet;
+			}
+			return true;
+		},
+		[&]() -> std::optional<Network::Packet> {
+			if (!last) {
+				return std::nullopt;
+			}
+			if (sent_y == last->y) {
+				repeated_y = last->y;
+				return std::nullopt;
+			}
+			sent_y = last->y;
+			return Network::Packet{0, last->x, last->y};
+		}
+	);
+}
+
+} // intcode
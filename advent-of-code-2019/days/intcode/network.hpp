@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "intcode.hpp"
+#include "rendezvous.hpp"
+
+namespace intcode {
+
+// Machines exchanging (address, x, y) packets, as Day 23's NICs do. Machine
+// `i` reads its address `i` first, then reads packets, or -1 when none is
+// waiting. The network runs in rounds: the machines with something to do
+// run in parallel until they wait for input, their outputs are grouped into
+// packets, and the packets are delivered in one batch per destination
+// before the next round. Machines that keep reading -1 without sending
+// anything are parked until a packet arrives, so an idle network costs no
+// rounds.
+class Network {
+public:
+	struct Packet {
+		Value address;
+		Value x;
+		Value y;
+	};
+
+	// Packets sent to an address no machine has, such as the NAT's 255.
+	// Returning false stops the network.
+	using Sink = std::function<bool(const Packet& packet)>;
+	// Called when every machine is parked or halted and no packet is in
+	// flight. Returns a packet to deliver, or nothing to stop the network.
+	using Idle = std::function<std::optional<Packet>()>;
+
+	// Rounds run on `workers` threads, the calling one included.
+	Network(const PagedMemory& image, std::size_t size, std::size_t workers = 1);
+
+	// Runs until `sink` or `idle` stops the network or every machine halted.
+	void run(const Sink& sink, const Idle& idle);
+
+	Program& get_program() {
+		return program;
+	}
+
+	// Reads of -1 without sending anything after which a machine is parked.
+	std::size_t patience = 2;
+
+	uint64_t rounds = 0;
+	uint64_t packets = 0;
+	// Times every machine was parked or halted with no packet in flight.
+	uint64_t idles = 0;
+
+private:
+	struct Node {
+		// Reads of -1 in a row without sending.
+		std::size_t polls = 0;
+		bool halted = false;
+	};
+
+	void work(std::size_t worker);
+	void run_machine(std::size_t index, std::vector<Packet>& sent);
+	bool deliver(const Packet& packet, const Sink& sink);
+
+	Program program;
+	std::vector<Node> nodes;
+	// Values waiting for each machine, delivered at the start of a round.
+	std::vector<std::vector<Value>> inboxes;
+	// Machines running this round, and the packets each worker's share sent.
+	std::vector<std::size_t> runnable;
+	std::vector<std::vector<Packet>> outboxes;
+	Rendezvous rendezvous;
+};
+
+// Day 23's NAT: keeps the last packet sent to its address and, when the
+// network idles, sends it to machine 0.
+class Nat {
+public:
+	explicit Nat(Value address = 255) :
+		address(address) {}
+
+	// Runs until the NAT sends machine 0 the same y twice in a row.
+	void run(Network& network);
+
+	// Y of the first packet the NAT received.
+	std::optional<Value> get_first_y() const {
+		return first_y;
+	}
+	// Y the NAT sent twice in a row.
+	std::optional<Value> get_repeated_y() const {
+		return repeated_y;
+	}
+
+private:
+	Value address;
+	std::optional<Network::Packet> last;
+	std::optional<Value> first_y;
+	std::optional<Value> sent_y;
+	std::optional<Value> repeated_y;
+};
+
+} // intcode
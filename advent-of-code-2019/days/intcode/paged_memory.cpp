@@ -0,0 +1,309 @@
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#include "paged_memory.hpp"
+
+namespace intcode {
+
+namespace {
+
+static_assert(offsetof(PagedMemory::Page, values) == 8);
+
+// Read-only page behind every cell never written. Its count never drops to
+// one, so writers, translated code included, always copy it first.
+Value* get_zero_frame() {
+	static PagedMemory::Page* page = [] {
+		auto page = new PagedMemory::Page;
+		page->references.store(2, std::memory_order_relaxed);
+		std::fill(std::begin(page->values), std::end(page->values), 0);
+		return page;
+	}();
+	return page->values;
+}
+
+Value* allocate_page() {
+	auto page = new PagedMemory::Page;
+	page->references.store(1, std::memory_order_relaxed);
+	std::fill(std::begin(page->values), std::end(page->values), 0);
+	return page->values;
+}
+
+void acquire(Value* frame) {
+	if (frame != get_zero_frame()) {
+		PagedMemory::get_page(frame)->references.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void drop(Value* frame) {
+	if (frame != get_zero_frame() &&
+		PagedMemory::get_page(frame)->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		delete PagedMemory::get_page(frame);
+	}
+}
+
+} // namespace
+
+PagedMemory::PagedMemory(const Memory& image) :
+	frames((image.size() + page_mask) >> page_bits),
+	length(image.size()),
+	resident(frames.size()) {
+	for (auto& frame : frames) {
+		frame = allocate_page();
+	}
+	for (std::size_t cell = 0; cell < image.size(); cell++) {
+		frames[cell >> page_bits][cell & page_mask] = image[cell];
+	}
+}
+
+PagedMemory::PagedMemory(const PagedMemory& other) :
+	frames(other.frames),
+	length(other.length),
+	resident(other.resident),
+	limit(other.limit) {
+	for (auto frame : frames) {
+		acquire(frame);
+	}
+	for (const auto& [key, table] : other.directory) {
+		auto& copy = directory[key] = std::make_unique<Table>(*table);
+		for (auto frame : copy->frames) {
+			acquire(frame);
+		}
+	}
+}
+
+PagedMemory::PagedMemory(PagedMemory&& other) noexcept :
+	frames(std::move(other.frames)),
+	directory(std::move(other.directory)),
+	length(other.length),
+	resident(other.resident),
+	limit(other.limit) {
+	other.frames.clear();
+	other.directory.clear();
+	other.length = 0;
+	other.resident = 0;
+}
+
+PagedMemory& PagedMemory::operator=(const PagedMemory& other) {
+	if (this != &other) {
+		PagedMemory copy(other);
+		*this = std::move(copy);
+	}
+	return *this;
+}
+
+PagedMemory& PagedMemory::operator=(PagedMemory&& other) noexcept {
+	if (this != &other) {
+		release();
+		frames = std::move(other.frames);
+		directory = std::move(other.directory);
+		length = other.length;
+		resident = other.resident;
+		limit = other.limit;
+		other.frames.clear();
+		other.directory.clear();
+		other.length = 0;
+		other.resident = 0;
+	}
+	return *this;
+}
+
+PagedMemory::~PagedMemory() {
+	release();
+}
+
+Value PagedMemory::at(std::size_t location) const {
+	if (location >= length) {
+		throw std::out_of_range("intcode: address " + std::to_string(location) + " out of memory");
+	}
+	return (*this)[location];
+}
+
+Memory PagedMemory::flatten() const {
+	Memory memory(length);
+	for (std::size_t cell = 0; cell < length; cell++) {
+		memory[cell] = (*this)[cell];
+	}
+	return memory;
+}
+
+bool PagedMemory::operator==(const PagedMemory& other) const {
+	if (length != other.length) {
+		return false;
+	}
+	for (std::size_t page = 0; page << page_bits < length; page++) {
+		auto frame = get_frame(page);
+		auto other_frame = other.get_frame(page);
+		if (frame != other_frame && !std::equal(frame, frame + page_size, other_frame)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+std::size_t PagedMemory::owned_pages() const {
+	auto owned = [](auto frame) {
+		return get_page(frame)->references.load(std::memory_order_relaxed) == 1;
+	};
+	auto pages = static_cast<std::size_t>(std::count_if(frames.begin(), frames.end(), owned));
+	for (const auto& [key, table] : directory) {
+		pages += std::count_if(std::begin(table->frames), std::end(table->frames), owned);
+	}
+	return pages;
+}
+
+std::vector<std::size_t> PagedMemory::get_changed_pages(const PagedMemory& since) const {
+	std::vector<std::size_t> pages;
+	for (const auto* memory : {this, &since}) {
+		for (std::size_t page = 0; page < memory->frames.size(); page++) {
+			pages.push_back(page);
+		}
+		for (const auto& [key, table] : memory->directory) {
+			for (std::size_t page = 0; page < table_size; page++) {
+				if (table->frames[page] != get_zero_frame()) {
+					pages.push_back(key << table_bits | page);
+				}
+			}
+		}
+	}
+	std::sort(pages.begin(), pages.end());
+	pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+	std::erase_if(pages, [&](auto page) {
+		return get_frame(page) == since.get_frame(page);
+	});
+	return pages;
+}
+
+std::vector<std::pair<std::size_t, const Value*>> PagedMemory::get_frames() const {
+	std::vector<std::pair<std::size_t, const Value*>> mapped;
+	for (std::size_t page = 0; page < frames.size(); page++) {
+		if (frames[page] != get_zero_frame()) {
+			mapped.emplace_back(page, frames[page]);
+		}
+	}
+	for (const auto& [key, table] : directory) {
+		for (std::size_t page = 0; page < table_size; page++) {
+			if (table->frames[page] != get_zero_frame()) {
+				mapped.emplace_back(key << table_bits | page, table->frames[page]);
+			}
+		}
+	}
+	std::sort(mapped.begin(), mapped.end());
+	return mapped;
+}
+
+std::size_t PagedMemory::resident_bytes() const {
+	return resident * sizeof(Page) + directory.size() * sizeof(Table) + frames.capacity() * sizeof(Value*);
+}
+
+Value* PagedMemory::get_frame(std::size_t page) const {
+	if (page < frames.size()) {
+		return frames[page];
+	}
+	auto table = directory.find(page >> table_bits);
+	if (table == directory.end()) {
+		return get_zero_frame();
+	}
+	return table->second->frames[page & (table_size - 1)];
+}
+
+Value PagedMemory::read_far(std::size_t location) const {
+	return get_frame(location >> page_bits)[location & page_mask];
+}
+
+Value*& PagedMemory::get_slot(std::size_t page) {
+	if (page < frames.size()) {
+		return frames[page];
+	}
+	// Growth just past the dense frames stays dense, so a program spilling
+	// over its image keeps the fast path; anything further goes sparse.
+	if (page < frames.size() * 2 + 8) {
+		auto size = page + 1;
+		charge((std::max(size, frames.capacity()) - frames.capacity()) * sizeof(Value*));
+		auto first = frames.size();
+		frames.resize(size, get_zero_frame());
+		for (auto moved = first; moved < size; moved++) {
+			// Pages written while still far move over with their values.
+			auto table = directory.find(moved >> table_bits);
+			if (table != directory.end()) {
+				std::swap(frames[moved], table->second->frames[moved & (table_size - 1)]);
+			}
+		}
+		return frames[page];
+	}
+
+	auto& table = directory[page >> table_bits];
+	if (!table) {
+		try {
+			charge(sizeof(Table));
+		} catch (...) {
+			directory.erase(page >> table_bits);
+			throw;
+		}
+		table = std::make_unique<Table>();
+		std::fill(std::begin(table->frames), std::end(table->frames), get_zero_frame());
+	}
+	return table->frames[page & (table_size - 1)];
+}
+
+void PagedMemory::set_far(std::size_t location, Value value) {
+	auto& frame = get_slot(location >> page_bits);
+	if (get_page(frame)->references.load(std::memory_order_acquire) != 1) {
+		unshare(frame);
+	}
+	frame[location & page_mask] = value;
+	length = std::max(length, location + 1);
+}
+
+Value* PagedMemory::map_frame(std::size_t page, const Value* shared) {
+	auto& frame = get_slot(page);
+	if (frame == get_zero_frame()) {
+		charge(sizeof(Page));
+		resident++;
+	}
+	auto mapped = shared ? const_cast<Value*>(shared) : allocate_page();
+	if (shared) {
+		acquire(mapped);
+	}
+	drop(frame);
+	frame = mapped;
+	return mapped;
+}
+
+void PagedMemory::unshare(Value*& frame) {
+	if (frame == get_zero_frame()) {
+		charge(sizeof(Page));
+		frame = allocate_page();
+		resident++;
+		return;
+	}
+	auto copy = allocate_page();
+	std::copy(frame, frame + page_size, copy);
+	// The other copies may have let go in the meantime.
+	drop(frame);
+	frame = copy;
+}
+
+void PagedMemory::charge(std::size_t bytes) const {
+	if (limit && resident_bytes() + bytes > limit) {
+		throw std::length_error("intcode: memory limit of " + std::to_string(limit) + " bytes exceeded");
+	}
+}
+
+void PagedMemory::release() {
+	for (auto frame : frames) {
+		drop(frame);
+	}
+	for (const auto& [key, table] : directory) {
+		for (auto frame : table->frames) {
+			drop(frame);
+		}
+	}
+	frames.clear();
+	directory.clear();
+	length = 0;
+	resident = 0;
+}
+
+} // intcode
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace intcode {
+
+using Value = int64_t;
+using Memory = std::vector<Value>;
+
+// Memory split into fixed-size pages shared between copies until one of
+// them writes, so copying costs a pointer per page instead of a value per
+// cell. Copies may run on different threads; a single memory may not.
+//
+// Pages around the program image are reached through a dense frame array,
+// pages at far addresses through a sparse directory of page tables. Pages
+// never written map to a shared zero page, so touching address 10^9 costs
+// one page rather than gigabytes.
+class PagedMemory {
+public:
+	static constexpr std::size_t page_bits = 9;
+	static constexpr std::size_t page_size = std::size_t{1} << page_bits;
+	static constexpr std::size_t page_mask = page_size - 1;
+	static constexpr std::size_t table_bits = 9;
+	static constexpr std::size_t table_size = std::size_t{1} << table_bits;
+
+	// Reference count in front of the values of each page, so translated
+	// code can tell shared pages from their frame pointer.
+	struct Page {
+		std::atomic<uint32_t> references;
+		uint32_t padding;
+		Value values[page_size];
+	};
+
+	PagedMemory() = default;
+	explicit PagedMemory(const Memory& image);
+	PagedMemory(const PagedMemory& other);
+	PagedMemory(PagedMemory&& other) noexcept;
+	PagedMemory& operator=(const PagedMemory& other);
+	PagedMemory& operator=(PagedMemory&& other) noexcept;
+	~PagedMemory();
+
+	// One past the highest cell loaded or written.
+	std::size_t size() const {
+		return length;
+	}
+
+	// Cells reached through the dense frame array.
+	std::size_t dense_size() const {
+		return frames.size() << page_bits;
+	}
+
+	// Cells never written read as zero, at any address.
+	Value operator[](std::size_t location) const {
+		auto page = location >> page_bits;
+		if (page < frames.size()) {
+			return frames[page][location & page_mask];
+		}
+		return read_far(location);
+	}
+
+	// Throws std::out_of_range past `size()`.
+	Value at(std::size_t location) const;
+
+	void set(std::size_t location, Value value) {
+		auto page = location >> page_bits;
+		if (page >= frames.size()) {
+			set_far(location, value);
+			return;
+		}
+		auto& frame = frames[page];
+		if (get_page(frame)->references.load(std::memory_order_acquire) != 1) {
+			unshare(frame);
+		}
+		frame[location & page_mask] = value;
+		length = std::max(length, location + 1);
+	}
+
+	Memory flatten() const;
+
+	// Same size and values, pages shared with `other` compared by frame.
+	bool operator==(const PagedMemory& other) const;
+
+	// Dense page frames indexed by `location >> page_bits`, for translated
+	// code. Pages never written point at the shared zero page.
+	Value* const* page_table() const {
+		return frames.data();
+	}
+
+	// Pages this memory does not share with any copy.
+	std::size_t owned_pages() const;
+	// Indices of the pages mapped differently from `since`: for a copy of
+	// `since`, those either side wrote since.
+	std::vector<std::size_t> get_changed_pages(const PagedMemory& since) const;
+	// Frames of the pages not mapped to the zero page, by page index, so
+	// savers can tell pages shared between memories apart.
+	std::vector<std::pair<std::size_t, const Value*>> get_frames() const;
+	// Maps `page` to `shared`, a frame of another memory, or to a fresh
+	// zeroed frame returned for a loader to fill in.
+	Value* map_frame(std::size_t page, const Value* shared = nullptr);
+	// Sets `size()` as a loader found it.
+	void set_size(std::size_t size) {
+		length = size;
+	}
+	std::size_t page_count() const {
+		return frames.size();
+	}
+
+	// Pages written by this memory or the one it was copied from, and the
+	// bytes they take together with the tables mapping them.
+	std::size_t resident_pages() const {
+		return resident;
+	}
+	std::size_t resident_bytes() const;
+
+	// Writes that would take `resident_bytes()` past `bytes` throw
+	// std::length_error; 0 is unlimited.
+	void set_limit(std::size_t bytes) {
+		limit = bytes;
+	}
+
+	static Page* get_page(Value* frame) {
+		return reinterpret_cast<Page*>(reinterpret_cast<char*>(frame) - offsetof(Page, values));
+	}
+
+private:
+	struct Table {
+		Value* frames[table_size];
+	};
+
+	Value* get_frame(std::size_t page) const;
+	Value*& get_slot(std::size_t page);
+	Value read_far(std::size_t location) const;
+	void set_far(std::size_t location, Value value);
+	void unshare(Value*& frame);
+	void charge(std::size_t bytes) const;
+	void release();
+
+	std::vector<Value*> frames;
+	std::unordered_map<std::size_t, std::unique_ptr<Table>> directory;
+	std::size_t length = 0;
+	std::size_t resident = 0;
+	std::size_t limit = 0;
+};
+
+} // intcode
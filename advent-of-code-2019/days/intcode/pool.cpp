@@ -0,0 +1,100 @@
+#include "pool.hpp"
+
+namespace intcode {
+
+Pool::Pool(std::size_t count) :
+	rendezvous(count, [this](std::size_t worker) { work(worker); }) {
+	for (std::size_t i = 0; i < rendezvous.size(); i++) {
+		auto& worker = workers.emplace_back(std::make_unique<Worker>());
+		worker->program.emplace(0, PagedMemory(), Data());
+	}
+}
+
+void Pool::for_each(const std::vector<Job>& batch_jobs, const Task& batch_task, const std::atomic<std::size_t>* batch_limit) {
+	jobs = &batch_jobs;
+	task = &batch_task;
+	limit = batch_limit;
+	failed = false;
+	for (std::size_t i = 0; i < workers.size(); i++) {
+		std::lock_guard share(workers[i]->m);
+		workers[i]->next = batch_jobs.size() * i / workers.size();
+		workers[i]->end = batch_jobs.size() * (i + 1) / workers.size();
+	}
+	rendezvous.run();
+}
+
+void Pool::work(std::size_t worker) {
+	auto& program = workers[worker]->program;
+	auto& comp = program.at(0);
+	while (!failed.load(std::memory_order_relaxed)) {
+		auto job = take(worker);
+		if (!job) {
+			if (!steal(worker)) {
+				return;
+			}
+			continue;
+		}
+		if (limit && *job >= limit->load(std::memory_order_relaxed)) {
+			continue;
+		}
+		// The first failure stops the other workers too.
+		try {
+			const auto& run = (*jobs)[*job];
+			comp.restore({*run.image, run.input, {}, 0, 0});
+			for (auto [cell, value] : run.patch) {
+				comp.cpu.memory.set(cell, value);
+			}
+			resume_decoded_program_on_computer_with_id(program, 0);
+			(*task)(worker, *job, comp);
+		} catch (...) {
+			failed = true;
+			throw;
+		}
+	}
+}
+
+std::optional<std::size_t> Pool::take(std::size_t worker) {
+	std::lock_guard lock(workers[worker]->m);
+	auto& share = *workers[worker];
+	if (share.next == share.end) {
+		return std::nullopt;
+	}
+	return share.next++;
+}
+
+// Takes the upper half of the largest share left. Shares are locked one at
+// a time, so two thieves never wait on each other.
+bool Pool::steal(std::size_t worker) {
+	for (;;) {
+		std::size_t victim = worker;
+		std::size_t most = 0;
+		for (std::size_t i = 0; i < workers.size(); i++) {
+			std::lock_guard lock(workers[i]->m);
+			if (workers[i]->end - workers[i]->next > most) {
+				most = workers[i]->end - workers[i]->next;
+				victim = i;
+			}
+		}
+		if (!most) {
+			return false;
+		}
+		std::size_t first = 0;
+		std::size_t end = 0;
+		{
+			std::lock_guard lock(workers[victim]->m);
+			auto& share = *workers[victim];
+			if (share.next == share.end) {
+				continue;
+			}
+			first = share.next + (share.end - share.next) / 2;
+			end = share.end;
+			share.end = first;
+		}
+		std::lock_guard lock(workers[worker]->m);
+		workers[worker]->next = first;
+		workers[worker]->end = end;
+		return true;
+	}
+}
+
+} // intcode
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "intcode.hpp"
+#include "rendezvous.hpp"
+
+namespace intcode {
+
+// Runs batches of independent programs on a fixed set of threads, the
+// calling one included. Each worker starts with an even share of the jobs
+// and, once done, steals half of the largest share left, so uneven jobs
+// still keep every thread busy. Workers reuse one computer each, whose
+// decoded code buffers keep their capacity from job to job.
+class Pool {
+public:
+	// A program run from the start of `image` on `input`, after setting
+	// the cells in `patch`, until it halts or wants more input.
+	struct Job {
+		const PagedMemory* image;
+		Data input;
+		std::vector<std::pair<Memory::size_type, Value>> patch;
+	};
+
+	explicit Pool(std::size_t workers = std::max(1u, std::thread::hardware_concurrency()));
+
+	std::size_t size() const {
+		return workers.size();
+	}
+
+	// Results of `extract(computer, job)` for every job, in job order.
+	template<typename Extract>
+	auto map(const std::vector<Job>& jobs, Extract extract) {
+		using Result = decltype(extract(std::declval<const Computer&>(), std::size_t{}));
+		std::vector<std::optional<Result>> results(jobs.size());
+		for_each(jobs, [&](std::size_t, std::size_t job, const Computer& comp) {
+			results[job] = extract(comp, job);
+		});
+		std::vector<Result> collected;
+		collected.reserve(results.size());
+		for (auto& result : results) {
+			collected.push_back(std::move(*result));
+		}
+		return collected;
+	}
+
+	// Folds `extract(computer, job)` for every job into `initial`, with a
+	// `combine` that is associative and commutative, as max or sum are.
+	template<typename Result, typename Extract, typename Combine>
+	Result reduce(const std::vector<Job>& jobs, Result initial, Extract extract, Combine combine) {
+		std::vector<Result> partial(workers.size(), initial);
+		for_each(jobs, [&](std::size_t worker, std::size_t job, const Computer& comp) {
+			partial[worker] = combine(std::move(partial[worker]), extract(comp, job));
+		});
+		for (auto& result : partial) {
+			initial = combine(std::move(initial), std::move(result));
+		}
+		return initial;
+	}
+
+	// Lowest job for which `predicate(computer, job)` holds. Jobs after a
+	// match are skipped.
+	template<typename Predicate>
+	std::optional<std::size_t> find_first(const std::vector<Job>& jobs, Predicate predicate) {
+		std::atomic<std::size_t> found = std::numeric_limits<std::size_t>::max();
+		for_each(jobs, [&](std::size_t, std::size_t job, const Computer& comp) {
+			if (predicate(comp, job)) {
+				auto best = found.load();
+				while (job < best && !found.compare_exchange_weak(best, job)) {}
+			}
+		}, &found);
+		if (found == std::numeric_limits<std::size_t>::max()) {
+			return std::nullopt;
+		}
+		return found.load();
+	}
+
+	using Task = std::function<void(std::size_t worker, std::size_t job, const Computer& comp)>;
+	// Runs every job below `*limit`, or every job, calling `task` on the
+	// worker that ran it. Rethrows the first exception a job or task threw.
+	void for_each(const std::vector<Job>& jobs, const Task& task, const std::atomic<std::size_t>* limit = nullptr);
+
+private:
+	struct Worker {
+		std::mutex m;
+		// Jobs `[next, end)` left to this worker.
+		std::size_t next = 0;
+		std::size_t end = 0;
+		Program program;
+	};
+
+	void work(std::size_t worker);
+	std::optional<std::size_t> take(std::size_t worker);
+	bool steal(std::size_t worker);
+
+	std::vector<std::unique_ptr<Worker>> workers;
+
+	// Current batch, set before the rendezvous runs it.
+	const std::vector<Job>* jobs = nullptr;
+	const Task* task = nullptr;
+	const std::atomic<std::size_t>* limit = nullptr;
+	std::atomic<bool> failed = false;
+	Rendezvous rendezvous;
+};
+
+} // intcode
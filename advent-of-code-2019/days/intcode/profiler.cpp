@@ -0,0 +1,102 @@
+#include <numeric>
+#include <string>
+
+#include "intcode.hpp"
+#include "profiler.hpp"
+
+namespace intcode {
+
+namespace {
+
+template<typename Counts>
+void write_counts(std::ostream& os, const Counts& counts) {
+	std::map<Value, uint64_t> sorted(counts.begin(), counts.end());
+	os << "{";
+	const char* separator = "";
+	for (const auto& [key, count] : sorted) {
+		os << separator << "\"" << key << "\": " << count;
+		separator = ", ";
+	}
+	os << "}";
+}
+
+} // namespace
+
+Profiler::Profiler() {
+	frames.push_back({-1, 0, 0, {}});
+}
+
+void Profiler::step(Value ip, const Operation& op) {
+	auto taken = last_jump && ip != last_next;
+	if (taken && last_return && frame) {
+		frame = frames[frame].caller;
+	} else if (taken && op.opcode == Type::BASE && op.operands[0] > 0 &&
+			static_cast<Parameter::Mode>(op.modes[0]) == Parameter::Mode::IMMEDIATE) {
+		auto index = frames.size();
+		auto [callee, added] = frames[frame].callees.try_emplace(ip, index);
+		index = callee->second;
+		if (added) {
+			frames.push_back({ip, frame, 0, {}});
+		}
+		frame = index;
+	}
+	frames[frame].steps++;
+
+	auto opcode = static_cast<uint8_t>(op.opcode);
+	opcodes[opcode]++;
+	words[op.modes[2] * 10000 + op.modes[1] * 1000 + op.modes[0] * 100 + opcode]++;
+	ips[ip]++;
+
+	last_next = ip + op.length;
+	last_jump = op.opcode == Type::JNZ || op.opcode == Type::JZ;
+	last_return = last_jump && static_cast<Parameter::Mode>(op.modes[1]) == Parameter::Mode::RELATIVE;
+}
+
+uint64_t Profiler::get_steps() const {
+	return std::accumulate(opcodes.begin(), opcodes.end(), uint64_t{0});
+}
+
+void Profiler::write_json(std::ostream& os) const {
+	os << "{\n\t\"steps\": " << get_steps() << ",\n\t\"opcodes\": {";
+	const char* separator = "";
+	for (std::size_t opcode = 0; opcode < opcodes.size(); opcode++) {
+		if (opcodes[opcode]) {
+			os << separator << "\"" << get_operation_name(static_cast<Type>(opcode)) << "\": " << opcodes[opcode];
+			separator = ", ";
+		}
+	}
+	os << "},\n\t\"modes\": ";
+	write_counts(os, words);
+	os << ",\n\t\"ips\": ";
+	write_counts(os, ips);
+	os << ",\n\t\"reads\": ";
+	write_counts(os, reads);
+	os << ",\n\t\"writes\": ";
+	write_counts(os, writes);
+	os << ",\n\t\"functions\": {";
+	std::map<Value, uint64_t> functions;
+	for (const auto& called : frames) {
+		functions[called.function] += called.steps;
+	}
+	separator = "";
+	for (const auto& [function, steps] : functions) {
+		os << separator << "\"" << (function < 0 ? "main" : std::to_string(function)) << "\": " << steps;
+		separator = ", ";
+	}
+	os << "}\n}\n";
+}
+
+void Profiler::write_folded(std::ostream& os) const {
+	for (const auto& called : frames) {
+		if (!called.steps) {
+			continue;
+		}
+		std::string stack;
+		for (auto at = &called; at->function >= 0; at = &frames[at->caller]) {
+			stack = ";fn_" + std::to_string(at->function) + stack;
+		}
+		os << "main" << stack << " " << called.steps << "\n";
+	}
+}
+
+} // intcode
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <map>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+#include "decoder.hpp"
+
+namespace intcode {
+
+// Execution profile of the decoded interpreter: dynamic counts per opcode,
+// per opcode and parameter modes and per instruction pointer, memory heat
+// maps and a call tree.
+//
+// Only compiled in with INTCODE_PROFILE defined; attach one through
+// `CPU::profiler`. Profiled runs stay on the interpreter, unfused, so every
+// instruction is seen.
+//
+// Calls are recognised from the relative base: a taken jump landing on a
+// BASE growing the stack enters a function there, a taken jump to an
+// address read relative to the base returns from it.
+class Profiler {
+public:
+	Profiler();
+
+	void step(Value ip, const Operation& op);
+	void read(Value location) {
+		reads[location]++;
+	}
+	void write(Value location) {
+		writes[location]++;
+	}
+
+	uint64_t get_steps() const;
+	void write_json(std::ostream& os) const;
+	// One line per call stack, as flamegraph.pl and speedscope read them.
+	void write_folded(std::ostream& os) const;
+
+private:
+	struct Frame {
+		Value function;
+		std::size_t caller;
+		uint64_t steps = 0;
+		std::map<Value, std::size_t> callees;
+	};
+
+	std::array<uint64_t, 100> opcodes = {};
+	// Keyed by the instruction word, opcode and modes together.
+	std::map<Value, uint64_t> words;
+	std::map<Value, uint64_t> ips;
+	std::unordered_map<Value, uint64_t> reads;
+	std::unordered_map<Value, uint64_t> writes;
+	std::vector<Frame> frames;
+	std::size_t frame = 0;
+
+	// The previous instruction, to tell taken jumps.
+	Value last_next = -1;
+	bool last_jump = false;
+	bool last_return = false;
+};
+
+} // intcode
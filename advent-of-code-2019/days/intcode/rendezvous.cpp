@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <utility>
+
+#include "rendezvous.hpp"
+
+namespace intcode {
+
+Rendezvous::Rendezvous(std::size_t workers, Step step) :
+	step(std::move(step)) {
+	for (std::size_t i = 1; i < std::max<std::size_t>(workers, 1); i++) {
+		threads.emplace_back(&Rendezvous::serve, this, i);
+	}
+}
+
+Rendezvous::~Rendezvous() {
+	{
+		std::lock_guard lock(m);
+		done = true;
+	}
+	cv.notify_all();
+	for (auto& thread : threads) {
+		thread.join();
+	}
+}
+
+void Rendezvous::run() {
+	{
+		std::lock_guard lock(m);
+		error = nullptr;
+		active = threads.size();
+		generation++;
+	}
+	cv.notify_all();
+	step_on(0);
+
+	std::unique_lock lock(m);
+	cv.wait(lock, [&] { return active == 0; });
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+void Rendezvous::serve(std::size_t worker) {
+	uint64_t seen = 0;
+	std::unique_lock lock(m);
+	for (;;) {
+		cv.wait(lock, [&] { return done || generation != seen; });
+		if (done) {
+			return;
+		}
+		seen = generation;
+		lock.unlock();
+		step_on(worker);
+		lock.lock();
+		if (--active == 0) {
+			cv.notify_all();
+		}
+	}
+}
+
+void Rendezvous::step_on(std::size_t worker) {
+	try {
+		step(worker);
+	} catch (...) {
+		std::lock_guard lock(m);
+		if (!error) {
+			error = std::current_exception();
+		}
+	}
+}
+
+} // intcode
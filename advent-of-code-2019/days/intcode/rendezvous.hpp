@@ -0,0 +1,49 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace intcode {
+
+// Threads that meet the calling one for every step: `run` hands the step
+// to all of them, the caller taking part as worker 0, and returns once
+// each has finished it. Between steps the threads sleep.
+class Rendezvous {
+public:
+	using Step = std::function<void(std::size_t worker)>;
+
+	// `workers` counts the calling thread, so 1 starts no thread.
+	Rendezvous(std::size_t workers, Step step);
+	~Rendezvous();
+	Rendezvous(const Rendezvous&) = delete;
+	Rendezvous& operator=(const Rendezvous&) = delete;
+
+	std::size_t size() const {
+		return threads.size() + 1;
+	}
+
+	// Rethrows the first exception a worker let out of the step, after
+	// all of them finished.
+	void run();
+
+private:
+	void serve(std::size_t worker);
+	void step_on(std::size_t worker);
+
+	Step step;
+	std::mutex m;
+	std::condition_variable cv;
+	uint64_t generation = 0;
+	std::size_t active = 0;
+	bool done = false;
+	std::exception_ptr error;
+	std::vector<std::thread> threads;
+};
+
+} // intcode
@@ -0,0 +1,125 @@
+#include <thread>
+#include <vector>
+
+#include "scheduler.hpp"
+
+namespace intcode {
+
+Scheduler::Scheduler(Program& program, OperationHooks hooks, Router router) :
+	program(program),
+	hooks(std::move(hooks)),
+	table(this->hooks),
+	router(std::move(router)) {
+	program.link();
+	slots = std::vector<Slot>(program.size());
+	for (std::size_t index = 0; index < program.size(); index++) {
+		ready.push_back(index);
+	}
+}
+
+// Computers feeding none keep their output.
+void Scheduler::forward(Scheduler& scheduler, Memory::size_type id) {
+	auto& program = scheduler.program;
+	auto index = program.get_index(id);
+	auto routes = program.get_routes(index);
+	if (routes.empty()) {
+		return;
+	}
+	auto& output = program[index].cpu.output;
+	std::lock_guard lock(scheduler.m);
+	for (auto value : output) {
+		for (auto target : routes) {
+			scheduler.deliver(target, value);
+		}
+	}
+	output.clear();
+}
+
+void Scheduler::send(Memory::size_type id, Value value) {
+	auto index = program.get_index(id);
+	std::lock_guard lock(m);
+	deliver(index, value);
+}
+
+void Scheduler::deliver(std::size_t index, Value value) {
+	auto& slot = slots[index];
+	if (!slot.overflow.empty() || !slot.mailbox.try_push(value)) {
+		slot.overflow.push_back(value);
+	}
+	if (slot.state == State::BLOCKED) {
+		slot.state = State::READY;
+		ready.push_back(index);
+		cv.notify_one();
+	}
+}
+
+bool Scheduler::has_mail(std::size_t index) const {
+	return slots[index].mailbox.size() || !slots[index].overflow.empty();
+}
+
+void Scheduler::collect(std::size_t index) {
+	auto& slot = slots[index];
+	auto& input = program[index].cpu.input;
+	Value value = 0;
+	while (slot.mailbox.try_pop(value)) {
+		input.push_back(value);
+	}
+	input.insert(input.end(), slot.overflow.begin(), slot.overflow.end());
+	slot.overflow.clear();
+}
+
+void Scheduler::run(std::size_t workers) {
+	std::vector<std::thread> threads;
+	for (std::size_t i = 1; i < workers; i++) {
+		threads.emplace_back(&Scheduler::work, this);
+	}
+	work();
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	for (std::size_t index = 0; index < slots.size(); index++) {
+		collect(index);
+	}
+}
+
+Status Scheduler::get_status(Memory::size_type id) const {
+	auto index = program.get_index(id);
+	std::lock_guard lock(m);
+	return slots[index].state == State::HALTED ? Status::HALTED : Status::BLOCKED;
+}
+
+void Scheduler::work() {
+	std::unique_lock lock(m);
+	for (;;) {
+		cv.wait(lock, [&] { return !ready.empty() || !running; });
+		if (ready.empty()) {
+			cv.notify_all();
+			return;
+		}
+		auto index = ready.front();
+		ready.pop_front();
+		auto& slot = slots[index];
+		collect(index);
+		slot.state = State::RUNNING;
+		running++;
+		lock.unlock();
+
+		auto id = program.get_id(index);
+		auto status = resume_decoded_program_on_computer_with_id(program, id, table);
+		router(*this, id);
+
+		lock.lock();
+		running--;
+		if (status == Status::HALTED) {
+			slot.state = State::HALTED;
+		} else if (has_mail(index)) {
+			slot.state = State::READY;
+			ready.push_back(index);
+		} else {
+			slot.state = State::BLOCKED;
+		}
+		cv.notify_all();
+	}
+}
+
+} // intcode
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "channel.hpp"
+#include "intcode.hpp"
+
+namespace intcode {
+
+// Multiplexes the computers of a program on the calling thread, or on a few
+// worker threads, instead of one thread per computer. A computer runs until
+// it waits for input or halts; its output is then handed to the router,
+// which sends values on to other computers.
+class Scheduler {
+public:
+	using Router = std::function<void(Scheduler&, Memory::size_type id)>;
+
+	Scheduler(Program& program, OperationHooks hooks = {}, Router router = forward);
+
+	// Sends the output of a computer along its routes.
+	static void forward(Scheduler& scheduler, Memory::size_type id);
+
+	void send(Memory::size_type id, Value value);
+	// Runs until every computer has halted or waits for input nobody will
+	// send. Values sent to halted computers end up in their CPU input.
+	void run(std::size_t workers = 1);
+	Status get_status(Memory::size_type id) const;
+
+	Program& program;
+
+private:
+	enum class State {
+		READY,
+		RUNNING,
+		BLOCKED,
+		HALTED,
+	};
+
+	// Values for a computer go through its channel, and once that is full
+	// through `overflow` until the computer takes them, which keeps them
+	// in order without ever blocking the sender.
+	struct Slot {
+		State state = State::READY;
+		Channel mailbox;
+		Data overflow;
+	};
+
+	void work();
+	// These are called with `m` held.
+	void deliver(std::size_t index, Value value);
+	bool has_mail(std::size_t index) const;
+	// Moves the values waiting for a computer to its CPU input.
+	void collect(std::size_t index);
+
+	OperationHooks hooks;
+	// Resolved once for every resumption.
+	OperationHookTable table;
+	Router router;
+	// By index in the program, fixed at construction as channels cannot move.
+	std::vector<Slot> slots;
+	std::deque<std::size_t> ready;
+	std::size_t running = 0;
+	mutable std::mutex m;
+	std::condition_variable cv;
+};
+
+} // intcode
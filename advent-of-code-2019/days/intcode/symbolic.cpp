@@ -0,0 +1,264 @@
+#include <algorithm>
+
+#include "symbolic.hpp"
+
+namespace intcode {
+
+namespace {
+
+using Cell = std::optional<Affine>;
+
+// The path depends on the symbols.
+struct Unsolvable {};
+
+Affine constant(Value value, std::size_t symbols) {
+	return {value, std::vector<Value>(symbols)};
+}
+
+Cell add(const Cell& a, const Cell& b) {
+	if (!a || !b) {
+		return std::nullopt;
+	}
+	auto sum = *a;
+	sum.constant += b->constant;
+	for (std::size_t i = 0; i < sum.coefficients.size(); i++) {
+		sum.coefficients[i] += b->coefficients[i];
+	}
+	return sum;
+}
+
+Cell multiply(const Cell& a, const Cell& b) {
+	if (!a || !b || (!a->is_constant() && !b->is_constant())) {
+		return std::nullopt;
+	}
+	auto product = a->is_constant() ? *b : *a;
+	auto factor = a->is_constant() ? a->constant : b->constant;
+	product.constant *= factor;
+	for (auto& coefficient : product.coefficients) {
+		coefficient *= factor;
+	}
+	return product;
+}
+
+// Known when both sides are constant, or differ by a constant.
+Cell compare(const Cell& a, const Cell& b, bool less) {
+	if (!a || !b || a->coefficients != b->coefficients) {
+		return std::nullopt;
+	}
+	auto result = less ? a->constant < b->constant : a->constant == b->constant;
+	return constant(result ? 1 : 0, a->coefficients.size());
+}
+
+Value get_known(const Cell& cell) {
+	if (!cell || !cell->is_constant()) {
+		throw Unsolvable();
+	}
+	return cell->constant;
+}
+
+class Machine {
+public:
+	Machine(const Memory& image, const std::vector<Memory::size_type>& symbols, const Data& input) :
+		input(input),
+		symbols(symbols.size()) {
+		for (auto value : image) {
+			result.memory.push_back(constant(value, symbols.size()));
+		}
+		for (std::size_t i = 0; i < symbols.size(); i++) {
+			auto symbol = constant(0, symbols.size());
+			symbol.coefficients[i] = 1;
+			cell(static_cast<Value>(symbols[i])) = symbol;
+		}
+	}
+
+	SymbolicResult run(uint64_t budget) {
+		for (;; result.steps++) {
+			if (result.steps == budget) {
+				throw Unsolvable();
+			}
+			auto instruction = get_known(read(ip));
+			modes = instruction / 100;
+			switch (static_cast<Type>(instruction % 100)) {
+			case Type::ADD:
+				write(2, add(get(0), get(1)));
+				ip += 4;
+				break;
+			case Type::MULTIPLY:
+				write(2, multiply(get(0), get(1)));
+				ip += 4;
+				break;
+			case Type::INPUT:
+				if (input.empty()) {
+					throw Unsolvable();
+				}
+				write(0, constant(input.front(), symbols));
+				input.pop_front();
+				ip += 2;
+				break;
+			case Type::OUTPUT:
+				result.output.push_back(get(0));
+				ip += 2;
+				break;
+			case Type::JNZ:
+			case Type::JZ:
+				if ((get_known(get(0)) != 0) == (static_cast<Type>(instruction % 100) == Type::JNZ)) {
+					ip = get_known(get(1));
+				} else {
+					ip += 3;
+				}
+				break;
+			case Type::LT:
+				write(2, compare(get(0), get(1), true));
+				ip += 4;
+				break;
+			case Type::EQ:
+				write(2, compare(get(0), get(1), false));
+				ip += 4;
+				break;
+			case Type::BASE:
+				base += get_known(get(0));
+				ip += 2;
+				break;
+			case Type::STOP:
+				return std::move(result);
+			default:
+				throw Unsolvable();
+			}
+		}
+	}
+
+private:
+	int mode(int parameter) const {
+		auto mode = modes;
+		for (int i = 0; i < parameter; i++) {
+			mode /= 10;
+		}
+		return static_cast<int>(mode % 10);
+	}
+
+	// Address of a parameter, empty when not known.
+	std::optional<Value> address(int parameter) {
+		auto operand = read(ip + 1 + parameter);
+		if (!operand || !operand->is_constant()) {
+			return std::nullopt;
+		}
+		switch (mode(parameter)) {
+		case 0:
+			return operand->constant;
+		case 2:
+			return base + operand->constant;
+		default:
+			throw Unsolvable();
+		}
+	}
+
+	Cell get(int parameter) {
+		if (mode(parameter) == 1) {
+			return read(ip + 1 + parameter);
+		}
+		auto location = address(parameter);
+		return location ? read(*location) : std::nullopt;
+	}
+
+	void write(int parameter, Cell value) {
+		auto location = address(parameter);
+		if (!location) {
+			throw Unsolvable();
+		}
+		cell(*location) = std::move(value);
+	}
+
+	Cell read(Value location) {
+		if (location < 0) {
+			throw Unsolvable();
+		}
+		if (static_cast<std::size_t>(location) >= result.memory.size()) {
+			return constant(0, symbols);
+		}
+		return result.memory[static_cast<std::size_t>(location)];
+	}
+
+	Cell& cell(Value location) {
+		// Far writes are left to the concrete engines.
+		if (location < 0 || location > (Value{1} << 24)) {
+			throw Unsolvable();
+		}
+		auto at = static_cast<std::size_t>(location);
+		if (at >= result.memory.size()) {
+			result.memory.resize(at + 1, constant(0, symbols));
+		}
+		return result.memory[at];
+	}
+
+	SymbolicResult result;
+	Data input;
+	std::size_t symbols;
+	Value ip = 0;
+	Value base = 0;
+	Value modes = 0;
+};
+
+std::optional<Memory> solve_from(const Affine& expression, Value target, const Memory& lower, const Memory& upper,
+	Memory& values, std::size_t symbol) {
+	auto coefficient = expression.coefficients[symbol];
+	// The last symbol is solved for, unless it does not matter.
+	if (symbol + 1 == values.size() && coefficient != 0) {
+		auto rest = target - expression.evaluate(values) + coefficient * values[symbol];
+		if (rest % coefficient == 0 && rest / coefficient >= lower[symbol] && rest / coefficient <= upper[symbol]) {
+			values[symbol] = rest / coefficient;
+			return values;
+		}
+		return std::nullopt;
+	}
+	for (auto value = lower[symbol]; value <= upper[symbol]; value++) {
+		values[symbol] = value;
+		if (symbol + 1 == values.size()) {
+			if (expression.evaluate(values) == target) {
+				return values;
+			}
+		} else if (auto solution = solve_from(expression, target, lower, upper, values, symbol + 1)) {
+			return solution;
+		}
+	}
+	return std::nullopt;
+}
+
+} // namespace
+
+bool Affine::is_constant() const {
+	return std::all_of(coefficients.begin(), coefficients.end(), [](auto coefficient) {
+		return coefficient == 0;
+	});
+}
+
+Value Affine::evaluate(const Memory& symbols) const {
+	auto value = constant;
+	for (std::size_t i = 0; i < coefficients.size(); i++) {
+		value += coefficients[i] * symbols[i];
+	}
+	return value;
+}
+
+std::optional<SymbolicResult> run_symbolic(const Memory& memory, const std::vector<Memory::size_type>& symbols,
+	const Data& input, uint64_t budget) {
+	try {
+		return Machine(memory, symbols, input).run(budget);
+	} catch (const Unsolvable&) {
+		return std::nullopt;
+	}
+}
+
+std::optional<Memory> solve(const Affine& expression, Value target, const Memory& lower, const Memory& upper) {
+	if (expression.coefficients.empty()) {
+		return expression.constant == target ? std::optional<Memory>(Memory()) : std::nullopt;
+	}
+	for (std::size_t i = 0; i < lower.size(); i++) {
+		if (lower[i] > upper[i]) {
+			return std::nullopt;
+		}
+	}
+	auto values = lower;
+	return solve_from(expression, target, lower, upper, values, 0);
+}
+
+} // intcode
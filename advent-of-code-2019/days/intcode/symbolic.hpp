@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+#include <optional>
+#include <vector>
+
+#include "intcode.hpp"
+
+namespace intcode {
+
+// Value affine in the symbols of a symbolic run:
+// `constant + sum(coefficients[i] * symbol i)`.
+struct Affine {
+	Value constant = 0;
+	std::vector<Value> coefficients;
+
+	bool is_constant() const;
+	Value evaluate(const Memory& symbols) const;
+	bool operator==(const Affine& other) const = default;
+};
+
+// Cells and outputs of a symbolic run, empty where a value is not affine in
+// the symbols.
+struct SymbolicResult {
+	std::vector<std::optional<Affine>> memory;
+	std::vector<std::optional<Affine>> output;
+	uint64_t steps = 0;
+};
+
+// Runs `memory` with the cells at `symbols` left unknown, tracking values
+// as affine expressions in them: sums, products by constants and
+// comparisons of values differing by a constant stay affine, anything else
+// goes unknown. Reads at unknown addresses give unknown values.
+//
+// The result holds for every value of the symbols, so it is empty when the
+// path taken depends on them: a jump, relative base or written address not
+// known, an instruction not known, running out of `input` or of `budget`
+// instructions.
+std::optional<SymbolicResult> run_symbolic(const Memory& memory, const std::vector<Memory::size_type>& symbols,
+	const Data& input = {}, uint64_t budget = 1 << 20);
+
+// Symbol values within `lower` and `upper`, both inclusive, for which
+// `expression` is `target`; the first in lexicographic order.
+std::optional<Memory> solve(const Affine& expression, Value target, const Memory& lower, const Memory& upper);
+
+} // intcode
@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+#include "trace.hpp"
+
+namespace intcode {
+
+namespace {
+
+constexpr uint8_t magic[] = {'I', 'C', 'T', 'R', 2};
+
+enum class Record : uint8_t {
+	INPUT = 1,
+	OUTPUT,
+	CHECKPOINT,
+};
+
+uint64_t get_executed(const Computer& comp) {
+	return comp.cpu.code.dispatches + comp.cpu.code.fused;
+}
+
+// Reads the varints written by TraceRecorder.
+class Reader {
+public:
+	explicit Reader(const std::vector<uint8_t>& log) : log(log) {}
+
+	bool done() const {
+		return at == log.size();
+	}
+
+	uint8_t byte() {
+		if (done()) {
+			throw std::runtime_error("intcode: truncated trace");
+		}
+		return log[at++];
+	}
+
+	uint64_t get() {
+		uint64_t value = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			auto next = byte();
+			value |= static_cast<uint64_t>(next & 0x7f) << shift;
+			if (!(next & 0x80)) {
+				return value;
+			}
+		}
+		throw std::runtime_error("intcode: malformed trace");
+	}
+
+	Value get_signed() {
+		auto value = get();
+		return static_cast<Value>(value >> 1) ^ -static_cast<Value>(value & 1);
+	}
+
+private:
+	const std::vector<uint8_t>& log;
+	std::size_t at = 0;
+};
+
+} // namespace
+
+TraceRecorder::TraceRecorder(const Computer& comp, uint64_t interval, std::size_t capacity) :
+	interval(interval),
+	next_checkpoint(interval) {
+	log.reserve(capacity);
+	for (auto byte : magic) {
+		log.push_back(byte);
+	}
+	checkpoint(comp);
+}
+
+Computer::RunResult TraceRecorder::run(Computer& comp, std::size_t outputs, uint64_t budget) {
+	auto& cpu = comp.cpu;
+	auto limit = steps + budget;
+	for (;;) {
+		auto slice = next_checkpoint - steps;
+		if (budget) {
+			slice = std::min(slice, limit - steps);
+		}
+		// Inputs are consumed from the front, outputs produced at the back.
+		Data pending = cpu.input;
+		auto produced = cpu.output.size();
+		auto executed = get_executed(comp);
+		auto result = comp.run(outputs, slice);
+		steps += get_executed(comp) - executed;
+
+		for (std::size_t i = 0; i < pending.size() - cpu.input.size(); i++) {
+			log.push_back(static_cast<uint8_t>(Record::INPUT));
+			put_signed(pending[i]);
+		}
+		for (auto value = cpu.output.begin() + static_cast<Data::difference_type>(produced); value != cpu.output.end(); value++) {
+			log.push_back(static_cast<uint8_t>(Record::OUTPUT));
+			put_signed(*value);
+		}
+		if (steps >= next_checkpoint) {
+			checkpoint(comp);
+		}
+		if (result.event != Event::BUDGET || (budget && steps >= limit)) {
+			return result;
+		}
+	}
+}
+
+void TraceRecorder::checkpoint(const Computer& comp) {
+	auto state = comp.snapshot();
+	auto pages = state.memory.get_changed_pages(last);
+	log.push_back(static_cast<uint8_t>(Record::CHECKPOINT));
+	put(steps);
+	put_signed(state.ip);
+	put_signed(state.base);
+	put(state.memory.size());
+	put(pages.size());
+	for (auto page : pages) {
+		put(page);
+		auto first = page << PagedMemory::page_bits;
+		for (std::size_t cell = 0; cell < PagedMemory::page_size; cell++) {
+			put_signed(state.memory[first + cell]);
+		}
+	}
+	last = std::move(state.memory);
+	next_checkpoint = steps + interval;
+}
+
+void TraceRecorder::save(std::ostream& os) const {
+	os.write(reinterpret_cast<const char*>(log.data()), static_cast<std::streamsize>(log.size()));
+}
+
+void TraceRecorder::put(uint64_t value) {
+	for (; value >= 0x80; value >>= 7) {
+		log.push_back(static_cast<uint8_t>(value | 0x80));
+	}
+	log.push_back(static_cast<uint8_t>(value));
+}
+
+// Zigzag encoded, so small negative values stay short too.
+void TraceRecorder::put_signed(Value value) {
+	put((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+TraceReplay::TraceReplay(const std::vector<uint8_t>& log) {
+	Reader reader(log);
+	for (auto expected : magic) {
+		if (reader.byte() != expected) {
+			throw std::runtime_error("intcode: not a trace");
+		}
+	}
+	PagedMemory memory;
+	while (!reader.done()) {
+		switch (static_cast<Record>(reader.byte())) {
+		case Record::INPUT:
+			inputs.push_back(reader.get_signed());
+			break;
+		case Record::OUTPUT:
+			outputs.push_back(reader.get_signed());
+			break;
+		case Record::CHECKPOINT: {
+			auto step = reader.get();
+			auto ip = reader.get_signed();
+			auto base = reader.get_signed();
+			auto size = reader.get();
+			for (auto pages = reader.get(); pages; pages--) {
+				auto first = reader.get() << PagedMemory::page_bits;
+				for (std::size_t cell = 0; cell < PagedMemory::page_size; cell++) {
+					memory.set(first + cell, reader.get_signed());
+				}
+			}
+			// Pages are logged whole, past the cells the computer wrote.
+			memory.set_size(size);
+			checkpoints.push_back({step, {memory, {}, {}, base, ip}, inputs.size()});
+			break;
+		}
+		default:
+			throw std::runtime_error("intcode: malformed trace");
+		}
+	}
+	if (checkpoints.empty()) {
+		throw std::runtime_error("intcode: trace without checkpoints");
+	}
+}
+
+TraceReplay TraceReplay::load(std::istream& is) {
+	std::vector<uint8_t> log((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+	return TraceReplay(log);
+}
+
+uint64_t TraceReplay::get_steps() const {
+	return checkpoints.back().step;
+}
+
+Snapshot TraceReplay::get_state_at(uint64_t step) const {
+	auto checkpoint = std::prev(std::upper_bound(checkpoints.begin(), checkpoints.end(), step,
+		[](uint64_t step, const Checkpoint& checkpoint) {
+			return step < checkpoint.step;
+		}));
+	Computer comp(checkpoint->state);
+	auto consumed = static_cast<Data::difference_type>(checkpoint->inputs);
+	comp.cpu.input.assign(inputs.begin() + consumed, inputs.end());
+	// Unfused, so the run stops on the exact step.
+	comp.cpu.code.fusion = false;
+	if (step > checkpoint->step) {
+		comp.run(0, step - checkpoint->step);
+	}
+	return comp.snapshot();
+}
+
+} // intcode
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "intcode.hpp"
+
+namespace intcode {
+
+// Compact binary log of a computer's execution: the inputs it consumed, the
+// outputs it produced and a checkpoint every `interval` instructions. A
+// checkpoint holds the instruction pointer, the relative base, the memory
+// size and the pages written since the previous one, found by comparing
+// copy-on-write frames.
+// Recording runs on the decoded interpreter, like Computer::run.
+class TraceRecorder {
+public:
+	// Starts the log with a checkpoint of the computer as it is.
+	explicit TraceRecorder(const Computer& comp, uint64_t interval = 1 << 16, std::size_t capacity = 1 << 20);
+
+	// Computer::run on `comp`, logging as it goes.
+	Computer::RunResult run(Computer& comp, std::size_t outputs = 0, uint64_t budget = 0);
+	// Logs a checkpoint now, as at the end of a recording.
+	void checkpoint(const Computer& comp);
+
+	uint64_t get_steps() const {
+		return steps;
+	}
+	const std::vector<uint8_t>& get_log() const {
+		return log;
+	}
+	void save(std::ostream& os) const;
+
+private:
+	void put(uint64_t value);
+	void put_signed(Value value);
+
+	uint64_t interval;
+	uint64_t steps = 0;
+	uint64_t next_checkpoint;
+	PagedMemory last;
+	std::vector<uint8_t> log;
+};
+
+// Rebuilds the state of a recorded computer at any step from the nearest
+// checkpoint before it, executing at most one interval.
+class TraceReplay {
+public:
+	// Throws std::runtime_error on logs it cannot read.
+	explicit TraceReplay(const std::vector<uint8_t>& log);
+	static TraceReplay load(std::istream& is);
+
+	// Steps up to the last checkpoint.
+	uint64_t get_steps() const;
+	const Data& get_inputs() const {
+		return inputs;
+	}
+	const Data& get_outputs() const {
+		return outputs;
+	}
+	// State after `step` instructions, its input holding the logged inputs
+	// still to be consumed and its output those produced since the
+	// checkpoint it started from.
+	Snapshot get_state_at(uint64_t step) const;
+
+private:
+	struct Checkpoint {
+		uint64_t step;
+		Snapshot state;
+		std::size_t inputs;
+	};
+
+	std::vector<Checkpoint> checkpoints;
+	Data inputs;
+	Data outputs;
+};
+
+} // intcode
@@ -1,3 +1,4 @@
+#include <fstream>
 #include <ios>
 #include <iomanip>
 #include <sstream>
@@ -18,3 +19,16 @@ std::vector<std::string> split_string_by(const std::string& src, const std::stri
 	boost::split(result, src, boost::is_any_of(delimiter));
 	return result;
 }
+
+std::string read_program(const std::string& path) {
+	std::ifstream file(path);
+	std::stringstream contents;
+	contents << file.rdbuf();
+	auto text = contents.str();
+	auto first = text.find('"');
+	auto last = text.find('"', first + 1);
+	if (first == std::string::npos || last == std::string::npos) {
+		return text;
+	}
+	return text.substr(first + 1, last - first - 1);
+}
@@ -9,6 +9,9 @@
 
 std::string int_to_str(int value);
 std::vector<std::string> split_string_by(const std::string& src, const std::string& delimiter);
+// Program text of a file: its first string literal, as the puzzle inputs
+// hold it, or the whole file when it has none.
+std::string read_program(const std::string& path);
 
 using ms = std::chrono::milliseconds;
 using us = std::chrono::microseconds;
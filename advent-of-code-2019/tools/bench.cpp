@@ -0,0 +1,936 @@
+// intcode-bench : Compares the Intcode engines on the heaviest puzzle programs.
+//
+// Usage: intcode-bench [repetitions]
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../days/intcode/batch.hpp"
+#include "../days/intcode/channel.hpp"
+#include "../days/intcode/checkpoint.hpp"
+#include "../days/intcode/console.hpp"
+#include "../days/intcode/guarded_memory.hpp"
+#include "../days/intcode/intcode.hpp"
+#include "../days/intcode/jit.hpp"
+#include "../days/intcode/memo.hpp"
+#include "../days/intcode/network.hpp"
+#include "../days/intcode/pool.hpp"
+#include "../days/intcode/scheduler.hpp"
+#include "../days/intcode/symbolic.hpp"
+#include "../days/intcode/trace.hpp"
+#include "../days/utils.hpp"
+
+namespace {
+
+struct AlarmSource {
+	#include "../days/02/puzzle_input"
+};
+
+struct AmplifierSource {
+	#include "../days/07/puzzle_input"
+};
+
+struct BoostSource {
+	#include "../days/09/puzzle_input"
+};
+
+struct ArcadeSource {
+	#include "../days/13/puzzle_input"
+};
+
+enum class Engine {
+	FACTORY,
+	UNFUSED,
+	INTERPRETER,
+	CHECKED,
+	JIT,
+	COMPILED,
+};
+
+std::string engine_name(Engine engine) {
+	switch (engine) {
+	case Engine::FACTORY:
+		return "instruction_factory";
+	case Engine::UNFUSED:
+		return "decoded, unfused";
+	case Engine::INTERPRETER:
+		return "decoded";
+	case Engine::CHECKED:
+		return "decoded, checked";
+	case Engine::JIT:
+		return "decoded + jit";
+	case Engine::COMPILED:
+		return "decoded + compiled";
+	default:
+		break;
+	}
+	return "";
+}
+
+void execute(std::unique_ptr<intcode::Instruction>& inst, intcode::CPU& cpu) {
+	inst->execute(cpu);
+}
+
+void execute(const intcode::Operation& op, intcode::CPU& cpu) {
+	op.execute(cpu);
+}
+
+intcode::Tier get_tier(Engine engine) {
+	switch (engine) {
+	case Engine::JIT:
+		return intcode::Tier::JIT;
+	case Engine::COMPILED:
+		return intcode::Tier::COMPILED;
+	default:
+		break;
+	}
+	return intcode::Tier::INTERPRETER;
+}
+
+// Dynamic instruction counts of the last decoded run.
+uint64_t dispatches = 0;
+uint64_t fused = 0;
+
+void prepare(intcode::CPU& cpu, Engine engine) {
+	cpu.code.fusion = engine != Engine::UNFUSED;
+	cpu.code.checked = engine == Engine::CHECKED;
+}
+
+void record(const intcode::CPU& cpu) {
+	dispatches = cpu.code.dispatches;
+	fused = cpu.code.fused;
+}
+
+using Clock = std::chrono::high_resolution_clock;
+
+// Fastest of `repetitions` runs of `task`, each after an untimed `setup`.
+template<typename Setup, typename Task>
+Clock::duration best_of(int repetitions, Setup setup, Task task) {
+	auto best = Clock::duration::max();
+	for (int i = 0; i < repetitions; i++) {
+		setup();
+		auto start = Clock::now();
+		task();
+		auto end = Clock::now();
+		best = std::min(best, end - start);
+	}
+	return best;
+}
+
+template<typename Task>
+Clock::duration best_of(int repetitions, Task task) {
+	return best_of(repetitions, [] {}, task);
+}
+
+std::string to_string(Clock::duration elapsed) {
+	auto zero = Clock::time_point();
+	return duration_to_string(zero, zero + elapsed);
+}
+
+// Plays the arcade game, following the ball with the paddle.
+template<typename TypeHooks>
+TypeHooks get_arcade_hooks(intcode::Value& ball, intcode::Value& paddle, intcode::Value& score) {
+	return {
+		{
+			intcode::Type::INPUT,
+			[&](intcode::Program&, intcode::Computer& comp, auto& inst) {
+				comp.cpu.input.push_back(ball > paddle ? 1 : (ball < paddle ? -1 : 0));
+				execute(inst, comp.cpu);
+			}
+		},
+		{
+			intcode::Type::OUTPUT,
+			[&](intcode::Program&, intcode::Computer& comp, auto& inst) {
+				execute(inst, comp.cpu);
+				auto& output = comp.cpu.output;
+				if (output.size() == 3) {
+					if (output[0] == -1 && output[1] == 0) {
+						score = output[2];
+					} else if (output[2] == 3) {
+						paddle = output[0];
+					} else if (output[2] == 4) {
+						ball = output[0];
+					}
+					output.clear();
+				}
+			}
+		},
+	};
+}
+
+intcode::Value run_boost(Engine engine) {
+	auto memory = intcode::get_memory_from_string(BoostSource().src);
+	auto program = intcode::get_program_for_memory_with_input_data(memory, {2});
+	if (engine == Engine::FACTORY) {
+		intcode::run_program_on_computer_with_id(program, 0);
+	} else {
+		prepare(program.at(0).cpu, engine);
+		intcode::run_decoded_program_on_computer_with_id(program, 0);
+		record(program.at(0).cpu);
+	}
+	return program.at(0).cpu.output.back();
+}
+
+intcode::Value run_arcade(Engine engine) {
+	auto memory = intcode::get_memory_from_string(ArcadeSource().src);
+	auto program = intcode::get_program_for_memory_with_patched_data(memory, {2}, 0);
+	intcode::Value ball = 0, paddle = 0, score = 0;
+	if (engine == Engine::FACTORY) {
+		auto hooks = get_arcade_hooks<intcode::Hooks>(ball, paddle, score);
+		intcode::run_program_on_computer_with_id(program, 0, hooks);
+	} else {
+		auto hooks = get_arcade_hooks<intcode::OperationHooks>(ball, paddle, score);
+		prepare(program.at(0).cpu, engine);
+		intcode::run_decoded_program_on_computer_with_id(program, 0, hooks);
+		record(program.at(0).cpu);
+	}
+	return score;
+}
+
+void benchmark(const std::string& name, std::function<intcode::Value(Engine)> task, int repetitions) {
+	std::cout << name << std::endl;
+	std::vector<Engine> engines = {Engine::FACTORY, Engine::UNFUSED, Engine::INTERPRETER, Engine::CHECKED};
+	if (intcode::Jit::available()) {
+		engines.push_back(Engine::JIT);
+	}
+	engines.push_back(Engine::COMPILED);
+	for (auto engine : engines) {
+		intcode::set_tier(get_tier(engine));
+		intcode::Value result = 0;
+		auto best = best_of(repetitions, [&] { result = task(engine); });
+		std::cout << "  " << engine_name(engine) << ": " << result << " in " << to_string(best) << std::endl;
+		if (engine == Engine::INTERPRETER) {
+			auto executed = dispatches + fused;
+			std::cout << "    fused " << fused << " of " << executed << " dynamic instructions ("
+				<< (executed ? 100 * fused / executed : 0) << "%)" << std::endl;
+		}
+	}
+	intcode::set_tier(intcode::Tier::INTERPRETER);
+}
+
+// Runs every Day 7 amplifier sequence and returns the strongest signal,
+// either loading the program for every amplifier or forking amplifiers that
+// already read their phase setting.
+constexpr intcode::Value amplifiers = 5;
+// Pages of the last forked amplifier, and those it had to copy.
+std::size_t fork_pages = 0;
+std::size_t fork_copies = 0;
+
+intcode::Value amplify(bool fork) {
+	intcode::Memory settings = {0, 1, 2, 3, 4};
+	std::vector<intcode::Snapshot> primed;
+	if (fork) {
+		auto memory = intcode::get_memory_from_string(AmplifierSource().src);
+		for (intcode::Value setting = 0; setting < amplifiers; setting++) {
+			auto program = intcode::get_program_for_memory_with_input_data(memory, {setting});
+			intcode::resume_decoded_program_on_computer_with_id(program, 0);
+			primed.push_back(program.at(0).snapshot());
+		}
+	}
+	intcode::Value best = 0;
+	do {
+		intcode::Value signal = 0;
+		for (auto setting : settings) {
+			auto program = fork ?
+				intcode::get_program_for_snapshot_with_input_data(primed[setting], {signal}) :
+				intcode::get_program_for_memory_with_input_data(
+					intcode::get_memory_from_string(AmplifierSource().src), {setting, signal});
+			intcode::resume_decoded_program_on_computer_with_id(program, 0);
+			signal = program.at(0).cpu.output.back();
+			fork_pages = program.at(0).cpu.memory.page_count();
+			fork_copies = program.at(0).cpu.memory.owned_pages();
+		}
+		best = std::max(best, signal);
+	} while (std::next_permutation(settings.begin(), settings.end()));
+	return best;
+}
+
+// Same, taking the outputs of (phase, signal) pairs seen before from a memo.
+intcode::Value amplify_memoized(intcode::Memo& memo) {
+	const auto& image = intcode::get_image_from_string(AmplifierSource().src);
+	intcode::Memory settings = {0, 1, 2, 3, 4};
+	intcode::Value best = 0;
+	do {
+		intcode::Value signal = 0;
+		for (auto setting : settings) {
+			signal = memo.run(image, {setting, signal}).back();
+		}
+		best = std::max(best, signal);
+	} while (std::next_permutation(settings.begin(), settings.end()));
+	return best;
+}
+
+void benchmark_fork(int repetitions) {
+	std::cout << "day07 amplifier sequences, 120 x " << amplifiers << " runs" << std::endl;
+	for (bool fork : {false, true}) {
+		intcode::Value result = 0;
+		auto best = best_of(repetitions, [&] { result = amplify(fork); });
+		std::cout << "  " << (fork ? "forked after phase setting" : "loaded for every run") << ": " << result
+			<< " in " << to_string(best) << std::endl;
+	}
+	std::cout << "    each fork copied " << fork_copies << " of " << fork_pages << " pages" << std::endl;
+	for (bool warm : {false, true}) {
+		intcode::Value result = 0;
+		intcode::Memo memo;
+		auto best = best_of(repetitions, [&] {
+			if (!warm) {
+				memo.clear();
+			}
+		}, [&] {
+			result = amplify_memoized(memo);
+		});
+		std::cout << "  " << (warm ? "memoized, warm" : "memoized, cold") << ": " << result
+			<< " in " << to_string(best) << std::endl;
+		std::cout << "    " << memo.get_hits() << " hits, " << memo.get_misses() << " misses" << std::endl;
+	}
+}
+
+// Mutex and condition variable guarded queue, as computers were linked
+// before channels.
+class LockedLink {
+public:
+	void push(intcode::Value value) {
+		std::lock_guard lock(m);
+		values.push_back(value);
+		cv.notify_one();
+	}
+
+	intcode::Value pop() {
+		std::unique_lock lock(m);
+		cv.wait(lock, [&] { return !values.empty(); });
+		auto value = values.front();
+		values.pop_front();
+		return value;
+	}
+
+private:
+	std::deque<intcode::Value> values;
+	std::mutex m;
+	std::condition_variable cv;
+};
+
+// Day 7's feedback loop over every phase permutation, either stepping the
+// amplifiers in ring order by hand or multiplexing them on `workers`
+// scheduler threads; the day itself uses one.
+intcode::Value feedback(std::size_t workers) {
+	static const auto memory = intcode::get_memory_from_string(AmplifierSource().src);
+	intcode::Memory settings = {5, 6, 7, 8, 9};
+	intcode::Value best = 0;
+	do {
+		auto program = intcode::get_program_for_memory_with_phase_settings(memory, settings);
+		if (workers) {
+			intcode::Scheduler scheduler(program);
+			scheduler.run(workers);
+		} else {
+			for (std::size_t i = 0;; i = (i + 1) % program.size()) {
+				auto [event, output] = program[i].run(1);
+				if (event != intcode::Event::OUTPUT) {
+					break;
+				}
+				program[(i + 1) % program.size()].cpu.input.push_back(output.front());
+				output.pop_front();
+			}
+		}
+		// The last signal is left waiting for the first amplifier.
+		best = std::max(best, program.at(settings[0]).cpu.input.back());
+	} while (std::next_permutation(settings.begin(), settings.end()));
+	return best;
+}
+
+// Outputs its one input and halts.
+constexpr const char* echo_source = "3,5,4,5,99,0";
+// Adds up as many inputs as cell 18 says, then outputs the sum.
+constexpr const char* sum_source = "3,16,1,16,17,17,1001,18,-1,18,1005,18,0,4,17,99,0,0,0";
+
+// Many computers routed into one, and one broadcasting to all others, on
+// `workers` scheduler threads. Throws unless every value arrives.
+void route(std::size_t sources, std::size_t workers) {
+	auto echo = intcode::get_memory_from_string(echo_source);
+	auto sum = intcode::get_memory_from_string(sum_source);
+
+	intcode::Program fan_in;
+	sum[18] = static_cast<intcode::Value>(sources);
+	fan_in.emplace(sources, sum, intcode::Data());
+	intcode::Value total = 0;
+	for (std::size_t id = 0; id < sources; id++) {
+		auto value = static_cast<intcode::Value>(id * id + 1);
+		fan_in.emplace(id, echo, intcode::Data{value});
+		fan_in.connect(id, sources);
+		total += value;
+	}
+	intcode::Scheduler(fan_in).run(workers);
+	const auto& bus = fan_in.at(sources);
+	if (bus.cpu.output.size() != 1 || bus.cpu.output.front() != total) {
+		throw std::runtime_error("scheduler fan-in lost values");
+	}
+
+	intcode::Program broadcast;
+	sum[18] = 1;
+	broadcast.emplace(0, echo, intcode::Data{42});
+	for (std::size_t id = 1; id <= sources; id++) {
+		broadcast.emplace(id, sum, intcode::Data());
+	}
+	broadcast.broadcast(0);
+	intcode::Scheduler(broadcast).run(workers);
+	for (std::size_t id = 1; id <= sources; id++) {
+		const auto& output = broadcast.at(id).cpu.output;
+		if (output.size() != 1 || output.front() != 42) {
+			throw std::runtime_error("scheduler broadcast missed computer " + std::to_string(id));
+		}
+	}
+}
+
+void benchmark_scheduler(int repetitions) {
+	std::cout << "day07 feedback loop, 120 permutations" << std::endl;
+	auto expected = feedback(0);
+	for (std::size_t workers : {0, 1, 4}) {
+		intcode::Value result = 0;
+		auto best = best_of(repetitions, [&] { result = feedback(workers); });
+		if (result != expected) {
+			throw std::runtime_error("scheduler feedback loop gave " + std::to_string(result));
+		}
+		auto name = workers ? "scheduler, " + std::to_string(workers) + " workers" : std::string("by hand");
+		std::cout << "  " << name << ": " << result << " in " << to_string(best) << std::endl;
+	}
+
+	constexpr std::size_t sources = 200;
+	std::cout << sources << " computers routed into one, then one broadcasting to " << sources << std::endl;
+	for (std::size_t workers : {1, 4}) {
+		auto best = best_of(repetitions, [&] { route(sources, workers); });
+		std::cout << "  " << workers << " workers: " << to_string(best) << std::endl;
+	}
+}
+
+// Passes a single value around five threads, like the Day 7 feedback loop,
+// and returns the values handed over per second.
+template<typename Link>
+double run_ring(int laps) {
+	constexpr std::size_t amplifiers = 5;
+	std::array<Link, amplifiers> links;
+	std::vector<std::thread> threads;
+	auto start = Clock::now();
+	for (std::size_t i = 0; i < amplifiers; i++) {
+		threads.emplace_back([&, i] {
+			auto& next = links[(i + 1) % amplifiers];
+			for (int lap = 0; lap < laps; lap++) {
+				next.push(links[i].pop() + 1);
+			}
+		});
+	}
+	links[0].push(0);
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	auto end = Clock::now();
+	std::chrono::duration<double> elapsed = end - start;
+	return laps * amplifiers / elapsed.count();
+}
+
+void benchmark_ring(int laps, int repetitions) {
+	std::cout << "5-amplifier ring, " << laps << " laps" << std::endl;
+	auto best = [&](auto run) {
+		double rate = 0;
+		for (int i = 0; i < repetitions; i++) {
+			rate = std::max(rate, run(laps));
+		}
+		return static_cast<uint64_t>(rate);
+	};
+	std::cout << "  mutex + condition_variable: " << best(run_ring<LockedLink>) << " values/s" << std::endl;
+	std::cout << "  spsc channel: " << best(run_ring<intcode::Channel>) << " values/s" << std::endl;
+}
+
+// Runs Day 2 for every noun and verb and returns the number of runs
+// producing the expected value, serially or as one batch.
+constexpr int sweep_range = 99;
+constexpr intcode::Value sweep_target = 19690720;
+
+intcode::Value sweep_serial() {
+	intcode::Value found = 0;
+	for (int noun = 0; noun < sweep_range; noun++) {
+		for (int verb = 0; verb < sweep_range; verb++) {
+			auto memory = intcode::get_memory_from_string(AlarmSource().source);
+			auto program = intcode::get_program_for_memory_with_patched_data(memory, {noun, verb});
+			intcode::run_decoded_program_on_computer_with_id(program, 0);
+			found += program.at(0).cpu.memory[0] == sweep_target;
+		}
+	}
+	return found;
+}
+
+// Counters of the last batch run.
+uint64_t vector_steps = 0;
+uint64_t lane_steps = 0;
+uint64_t peeled = 0;
+
+intcode::Value sweep_batch(bool avx2, bool narrow = true, bool checked = false) {
+	auto memory = intcode::get_memory_from_string(AlarmSource().source);
+	intcode::Batch batch(memory, sweep_range * sweep_range, narrow);
+	batch.avx2 = avx2;
+	batch.checked = checked;
+	for (std::size_t lane = 0; lane < batch.size(); lane++) {
+		batch.patch(lane, 1, lane / sweep_range);
+		batch.patch(lane, 2, lane % sweep_range);
+	}
+	batch.run();
+	intcode::Value found = 0;
+	for (std::size_t lane = 0; lane < batch.size(); lane++) {
+		found += batch.get(lane, 0) == sweep_target;
+	}
+	vector_steps = batch.vector_steps;
+	lane_steps = batch.lane_steps;
+	peeled = batch.peeled;
+	return found;
+}
+
+// Counts the same runs from the closed form of cell 0 in the noun and verb,
+// solving for the verb of each noun.
+intcode::Value sweep_symbolic() {
+	auto memory = intcode::get_memory_from_string(AlarmSource().source);
+	auto result = intcode::run_symbolic(memory, {1, 2});
+	if (!result || !result->memory[0]) {
+		return -1;
+	}
+	intcode::Value found = 0;
+	for (intcode::Value noun = 0; noun < sweep_range; noun++) {
+		found += intcode::solve(*result->memory[0], sweep_target, {noun, 0}, {noun, sweep_range - 1}).has_value();
+	}
+	return found;
+}
+
+void benchmark_sweep(int repetitions) {
+	std::cout << "day02 noun/verb sweep, " << sweep_range * sweep_range << " runs" << std::endl;
+	auto time = [&](const std::string& name, auto task) {
+		intcode::Value result = 0;
+		auto best = best_of(repetitions, [&] { result = task(); });
+		std::cout << "  " << name << ": " << result << " found in " << to_string(best) << std::endl;
+	};
+	time("decoded, one run each", sweep_serial);
+	time("batch, scalar kernels", [] { return sweep_batch(false); });
+	time("batch, scalar kernels, 64-bit cells", [] { return sweep_batch(false, false); });
+	time("batch, checked 64-bit cells", [] { return sweep_batch(false, false, true); });
+	if (intcode::Batch::has_avx2()) {
+		time("batch, avx2 kernels", [] { return sweep_batch(true); });
+		time("batch, avx2 kernels, 64-bit cells", [] { return sweep_batch(true, false); });
+	}
+	std::cout << "    " << vector_steps << " vector steps, " << lane_steps
+		<< " lane by lane, " << peeled << " lanes peeled" << std::endl;
+	time("symbolic, solved", sweep_symbolic);
+}
+
+// Whether two states agree in every field a computer resumes from.
+bool same_state(const intcode::Snapshot& a, const intcode::Snapshot& b) {
+	return a.ip == b.ip && a.base == b.base && a.input == b.input && a.output == b.output &&
+		a.memory == b.memory;
+}
+
+// Runs Day 9 plainly and under the trace recorder, then rebuilds the state
+// halfway through from the trace and by running again from the start.
+void benchmark_trace(int repetitions) {
+	std::cout << "day09 BOOST, input 2, traced" << std::endl;
+	const auto& image = intcode::get_image_from_string(BoostSource().src);
+	auto time = [&](const std::string& name, auto task) {
+		std::cout << "  " << name << ": " << to_string(best_of(repetitions, task)) << std::endl;
+	};
+	time("untraced", [&] {
+		auto program = intcode::get_program_for_memory_with_input_data(image, {2});
+		program.at(0).run();
+	});
+	std::vector<uint8_t> log;
+	time("traced", [&] {
+		auto program = intcode::get_program_for_memory_with_input_data(image, {2});
+		intcode::TraceRecorder recorder(program.at(0));
+		recorder.run(program.at(0));
+		recorder.checkpoint(program.at(0));
+		log = recorder.get_log();
+	});
+	intcode::TraceReplay replay(log);
+	auto middle = replay.get_steps() / 2;
+	std::cout << "    " << log.size() << " bytes for " << replay.get_steps() << " steps" << std::endl;
+	intcode::Snapshot replayed;
+	time("state at step " + std::to_string(middle) + " from the trace", [&] {
+		replayed = replay.get_state_at(middle);
+	});
+	intcode::Snapshot run;
+	time("state at step " + std::to_string(middle) + " from the start", [&] {
+		auto program = intcode::get_program_for_memory_with_input_data(image, {2});
+		program.at(0).cpu.code.fusion = false;
+		program.at(0).run(0, middle);
+		run = program.at(0).snapshot();
+	});
+	if (!same_state(replayed, run)) {
+		throw std::runtime_error("trace replay disagrees with the run at step " + std::to_string(middle));
+	}
+}
+
+// Plays the arcade game for up to `moves` joystick moves, returning the
+// score so far.
+intcode::Event resume(intcode::Computer& comp, std::size_t outputs, intcode::Data*& input, intcode::Data*& output) {
+	auto result = comp.run(outputs);
+	input = &comp.cpu.input;
+	output = &result.output;
+	return result.event;
+}
+
+intcode::Event resume(intcode::GuardedComputer& comp, std::size_t outputs, intcode::Data*& input, intcode::Data*& output) {
+	input = &comp.input;
+	output = &comp.output;
+	return comp.run(outputs);
+}
+
+// Plays free play for `moves` joystick moves, -1 playing to the end.
+template<typename Machine>
+intcode::Value play(Machine& arcade, int moves) {
+	intcode::Value ball = 0, paddle = 0, score = 0;
+	intcode::Data* input = nullptr;
+	intcode::Data* outputs = nullptr;
+	for (;;) {
+		auto event = resume(arcade, 3, input, outputs);
+		auto& output = *outputs;
+		if (event == intcode::Event::INPUT) {
+			if (moves-- == 0) {
+				return score;
+			}
+			input->push_back(ball > paddle ? 1 : (ball < paddle ? -1 : 0));
+		} else if (event == intcode::Event::OUTPUT) {
+			if (output[0] == -1 && output[1] == 0) {
+				score = output[2];
+			} else if (output[2] == 3) {
+				paddle = output[0];
+			} else if (output[2] == 4) {
+				ball = output[0];
+			}
+			output.clear();
+		} else {
+			return score;
+		}
+	}
+}
+
+// Resumes the arcade game half way through, from a checkpoint and by
+// replaying the moves.
+void benchmark_checkpoint(int repetitions) {
+	const int moves = 3000;
+	std::cout << "day13 arcade, resumed after " << moves << " moves" << std::endl;
+	const auto& image = intcode::get_image_from_string(ArcadeSource().src);
+	auto time = [&](const std::string& name, auto task) {
+		std::cout << "  " << name << ": " << to_string(best_of(repetitions, task)) << std::endl;
+	};
+	auto program = intcode::get_program_for_memory_with_patched_data(image, {2}, 0);
+	play(program.at(0), moves);
+	std::string saved;
+	time("save", [&] {
+		std::ostringstream os;
+		intcode::save_checkpoint(program, os);
+		saved = os.str();
+	});
+	std::cout << "    " << saved.size() << " bytes" << std::endl;
+	intcode::Snapshot loaded;
+	time("load", [&] {
+		std::istringstream is(saved);
+		loaded = intcode::load_checkpoint(is).at(0).snapshot();
+	});
+	intcode::Snapshot replayed;
+	time("replay", [&] {
+		auto program = intcode::get_program_for_memory_with_patched_data(image, {2}, 0);
+		play(program.at(0), moves);
+		replayed = program.at(0).snapshot();
+	});
+	if (!same_state(loaded, program.at(0).snapshot()) || !same_state(replayed, loaded)) {
+		throw std::runtime_error("checkpoint disagrees with the game it was saved from");
+	}
+	intcode::Computer resumed(loaded);
+	if (play(resumed, -1) != play(program.at(0), -1)) {
+		throw std::runtime_error("game resumed from the checkpoint ends differently");
+	}
+}
+
+// NIC in the style of Day 23: machine `a` sends (a + 1, 0, a) to start, then
+// forwards every (x, y) it receives to its successor as (x + 1, y), or to
+// the NAT once x reaches the hop count. Cells 68 and 69 hold the number of
+// machines, which is also the NAT's address, and the hop count.
+constexpr const char* token_ring_source =
+	"3,63,1001,63,1,64,8,64,68,65,1006,65,17,1101,0,0,64,4,64,104,0,4,63,3,66,1008,66,-1,65,"
+	"1005,65,23,3,67,1001,66,1,66,7,66,69,65,1005,65,54,4,68,4,66,4,67,1105,1,23,4,64,4,66,"
+	"4,67,1105,1,23,0,0,0,0,0,0,0";
+
+// Passes one token per machine around rings of NICs until the NAT sees the
+// network idle twice with the same packet.
+void benchmark_network(int repetitions) {
+	constexpr intcode::Value hops = 100;
+	std::size_t cores = std::max(1u, std::thread::hardware_concurrency());
+	for (std::size_t size : {50, 2000}) {
+		auto image = intcode::get_image_from_string(token_ring_source);
+		image.set(68, static_cast<intcode::Value>(size));
+		image.set(69, hops);
+		std::cout << "token ring, " << size << " NICs, " << hops << " hops, " << cores << " cores" << std::endl;
+		for (std::size_t workers = 1;; workers = std::min(workers * 2, cores)) {
+			intcode::Nat nat(static_cast<intcode::Value>(size));
+			std::optional<intcode::Network> network;
+			auto best = best_of(repetitions, [&] {
+				network.reset();
+				network.emplace(image, size, workers);
+				nat = intcode::Nat(static_cast<intcode::Value>(size));
+			}, [&] {
+				nat.run(*network);
+			});
+			std::cout << "  " << workers << " workers: NAT saw " << nat.get_first_y().value_or(-1)
+				<< " first and " << nat.get_repeated_y().value_or(-1) << " twice, " << network->packets
+				<< " packets in " << network->rounds << " rounds, " << to_string(best) << std::endl;
+			if (workers == cores) {
+				break;
+			}
+		}
+	}
+}
+
+// Runs the Day 2 sweep as independent jobs on 1 to N workers, counting
+// the matches and finding the first.
+void benchmark_pool(int repetitions) {
+	const auto& image = intcode::get_image_from_string(AlarmSource().source);
+	std::vector<intcode::Pool::Job> jobs;
+	for (intcode::Value noun = 0; noun < sweep_range; noun++) {
+		for (intcode::Value verb = 0; verb < sweep_range; verb++) {
+			jobs.push_back({&image, {}, {{1, noun}, {2, verb}}});
+		}
+	}
+	auto matches = [](const intcode::Computer& comp, std::size_t) {
+		return comp.cpu.memory[0] == sweep_target;
+	};
+	std::size_t cores = std::max(1u, std::thread::hardware_concurrency());
+	std::cout << "day02 noun/verb sweep on a pool, " << jobs.size() << " jobs, " << cores << " cores" << std::endl;
+	for (std::size_t workers = 1;; workers = std::min(workers * 2, cores)) {
+		intcode::Pool pool(workers);
+		auto time = [&](const std::string& name, auto task) {
+			intcode::Value result = 0;
+			auto best = best_of(repetitions, [&] { result = task(); });
+			std::cout << "  " << workers << " workers, " << name << ": " << result << " in " << to_string(best) << std::endl;
+		};
+		time("counted", [&] {
+			return pool.reduce(jobs, intcode::Value{0}, [&](const intcode::Computer& comp, std::size_t job) {
+				return intcode::Value{matches(comp, job)};
+			}, std::plus<>());
+		});
+		time("first match", [&] {
+			auto job = pool.find_first(jobs, matches);
+			return job ? static_cast<intcode::Value>(*job) : -1;
+		});
+		if (workers == cores) {
+			break;
+		}
+	}
+}
+
+// Parses the way sources were parsed before the single-pass parser.
+intcode::Memory parse_split(const std::string& source) {
+	intcode::Memory memory;
+	for (const auto& elem : split_string_by(source, ",")) {
+		memory.push_back(std::stoll(elem));
+	}
+	return memory;
+}
+
+// Parses a few megabytes of Intcode, made of copies of the Day 13 program.
+void benchmark_parse(int repetitions) {
+	std::string arcade = ArcadeSource().src;
+	std::string source = arcade;
+	while (source.size() < (4 << 20)) {
+		source += "," + arcade;
+	}
+	std::cout << "parsing " << (source.size() >> 10) << " KiB of source" << std::endl;
+	auto time = [&](const std::string& name, auto task) {
+		std::size_t cells = 0;
+		auto best = best_of(repetitions, [&] { cells = task(); });
+		std::chrono::duration<double> seconds = best;
+		std::cout << "  " << name << ": " << cells << " cells in " << to_string(best)
+			<< " (" << static_cast<uint64_t>(static_cast<double>(source.size()) / seconds.count()) / (1 << 20) << " MiB/s)" << std::endl;
+	};
+	time("split and stoll", [&] { return parse_split(source).size(); });
+	time("from_chars", [&] { return intcode::get_memory_from_string(source).size(); });
+	time("cached image", [&] { return intcode::get_image_from_string(source).size(); });
+}
+
+// Writes to far addresses, which would have grown memory to gigabytes
+// before it was sparse, then walks pages until a limit stops it.
+void report_sparse() {
+	std::cout << "sparse memory" << std::endl;
+	auto program = intcode::get_program_for_memory_with_input_data({
+		1101, 7, 8, 1000000000,
+		1101, 0, 3, 1000000000000,
+		1, 1000000000, 1000000000000, 5000,
+		4, 5000,
+		99,
+	}, {});
+	intcode::run_decoded_program_on_computer_with_id(program, 0);
+	const auto& memory = program.at(0).cpu.memory;
+	std::cout << "  writes at 10^9 and 10^12: " << program.at(0).cpu.output.back() << " with "
+		<< memory.resident_bytes() / 1024 << " KiB resident" << std::endl;
+
+	constexpr std::size_t limit = 1 << 20;
+	auto walker = intcode::get_program_for_memory_with_input_data({
+		109, 1000000000,
+		21101, 1, 0, 0,
+		109, static_cast<intcode::Value>(intcode::PagedMemory::page_size),
+		1105, 1, 2,
+	}, {});
+	walker.at(0).cpu.memory.set_limit(limit);
+	try {
+		intcode::run_decoded_program_on_computer_with_id(walker, 0);
+	} catch (const std::length_error&) {
+		const auto& walked = walker.at(0).cpu.memory;
+		std::cout << "  page walk stopped by a " << limit / 1024 << " KiB limit after "
+			<< walked.resident_pages() << " pages, " << walked.resident_bytes() / 1024 << " KiB resident" << std::endl;
+	}
+}
+
+// Stores 7 at cell 100000000 through the relative base, then prints that
+// cell and the one after it.
+constexpr const char* far_write_source = "109,100000000,21101,7,0,0,204,0,204,1,99";
+
+intcode::Value check_far_write(const intcode::Data& output) {
+	if (output != intcode::Data{7, 0}) {
+		throw std::runtime_error("far write read back wrong");
+	}
+	return output.front();
+}
+
+// Runs days 9 and 13 on the decoded interpreter over paged memory, then
+// straight from guarded memory, indexed without bounds checks. A far write
+// then runs on both, taking the fault path in guarded memory.
+void benchmark_guarded(int repetitions) {
+	if (!intcode::GuardedMemory::available()) {
+		return;
+	}
+	auto boost = intcode::get_memory_from_string(BoostSource().src);
+	auto arcade = intcode::get_memory_from_string(ArcadeSource().src);
+	arcade[0] = 2;
+	auto measure = [&](const std::string& name, auto task) {
+		intcode::Value result = 0;
+		auto best = best_of(repetitions, [&] { result = task(); });
+		std::cout << "  " << name << ": " << result << " in " << to_string(best) << std::endl;
+	};
+
+	std::cout << "guarded memory" << std::endl;
+	uint64_t faults = 0;
+	measure("day09 BOOST, paged", [&] {
+		intcode::Computer comp(boost, {2});
+		comp.run();
+		return comp.cpu.output.back();
+	});
+	measure("day09 BOOST, guarded", [&] {
+		intcode::GuardedComputer comp(boost, {2});
+		comp.run();
+		faults = comp.memory.faults();
+		return comp.output.back();
+	});
+	std::cout << "    " << faults << " chunks committed on fault" << std::endl;
+	measure("day13 arcade, paged", [&] {
+		intcode::Computer comp(arcade, {});
+		return play(comp, -1);
+	});
+	measure("day13 arcade, guarded", [&] {
+		intcode::GuardedComputer comp(arcade, {});
+		auto score = play(comp, -1);
+		faults = comp.memory.faults();
+		return score;
+	});
+	std::cout << "    " << faults << " chunks committed on fault" << std::endl;
+
+	// A store far past the image lands in a chunk only the fault handler
+	// commits; the cell after it was never written and reads as zero.
+	auto far = intcode::get_memory_from_string(far_write_source);
+	measure("far write, paged", [&] {
+		intcode::Computer comp(far, {});
+		comp.run();
+		return check_far_write(comp.cpu.output);
+	});
+	measure("far write, guarded", [&] {
+		intcode::GuardedComputer comp(far, {});
+		comp.run();
+		faults = comp.memory.faults();
+		return check_far_write(comp.output);
+	});
+	if (!faults) {
+		throw std::runtime_error("far write committed its chunk without a fault");
+	}
+	std::cout << "    " << faults << " chunks committed on fault" << std::endl;
+}
+
+// Prints one pangram per line, as many times as cell 25 says.
+constexpr const char* pangram_source =
+	"109,26,1206,0,12,204,0,109,1,1105,1,2,1001,25,-1,25,1006,25,24,109,-44,1105,1,2,99,0,"
+	"84,104,101,32,113,117,105,99,107,32,98,114,111,119,110,32,102,111,120,32,106,117,109,112,"
+	"115,32,111,118,101,114,32,116,104,101,32,108,97,122,121,32,100,111,103,10,0";
+
+// Streams a long ASCII transcript to /dev/null, once collected and written
+// with a flush per line, and once through a console.
+void benchmark_console(int repetitions) {
+	constexpr intcode::Value lines = 100000;
+	auto memory = intcode::get_memory_from_string(pangram_source);
+	memory[25] = lines;
+	std::cout << "ASCII output, " << lines << " lines" << std::endl;
+
+	std::ofstream sink("/dev/null");
+	auto best = best_of(repetitions, [&] {
+		auto program = intcode::get_program_for_memory_with_input_data(memory, {});
+		intcode::run_decoded_program_on_computer_with_id(program, 0);
+		for (auto value : program.at(0).cpu.output) {
+			if (value == '\n') {
+				sink << std::endl;
+			} else {
+				sink << static_cast<char>(value);
+			}
+		}
+	});
+	std::cout << "  collected, flushed per line: " << lines << " writes, " << to_string(best) << std::endl;
+
+	auto fd = ::open("/dev/null", O_RDWR);
+	if (fd < 0) {
+		throw std::runtime_error("cannot open /dev/null");
+	}
+	uint64_t writes = 0;
+	best = best_of(repetitions, [&] {
+		auto program = intcode::get_program_for_memory_with_input_data(memory, {});
+		intcode::Console console(fd, fd);
+		console.run(program.at(0));
+		writes = console.writes;
+	});
+	::close(fd);
+	std::cout << "  console: " << writes << " writes, " << to_string(best) << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+	int repetitions = argc > 1 ? std::stoi(argv[1]) : 5;
+	benchmark_sweep(repetitions);
+	benchmark_pool(repetitions);
+	benchmark_fork(repetitions);
+	benchmark("day09 BOOST, input 2", run_boost, repetitions);
+	benchmark("day13 arcade, free play", run_arcade, repetitions);
+	benchmark_guarded(repetitions);
+	benchmark_ring(20000, repetitions);
+	benchmark_scheduler(repetitions);
+	benchmark_network(repetitions);
+	benchmark_console(repetitions);
+	benchmark_trace(repetitions);
+	benchmark_checkpoint(repetitions);
+	benchmark_parse(repetitions);
+	report_sparse();
+	return 0;
+}
@@ -0,0 +1,46 @@
+// intcode-console : Runs an ASCII Intcode program on standard input and output.
+//
+// Usage: intcode-console <program> [input...]
+//
+// The program file holds the program as its first string literal, as the
+// puzzle inputs do, or as bare comma-separated values. Numbers given after
+// it are read before standard input. Exits with 0 once the program halts
+// and with 2 when standard input ends while it waits for more.
+
+#include <iostream>
+#include <string>
+
+#include <unistd.h>
+
+#include "../days/intcode/console.hpp"
+#include "../days/intcode/intcode.hpp"
+#include "../days/utils.hpp"
+
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		std::cerr << "usage: " << argv[0] << " <program> [input...]" << std::endl;
+		return 1;
+	}
+	auto source = read_program(argv[1]);
+	if (source.find_first_of("0123456789") == std::string::npos) {
+		std::cerr << argv[1] << ": no program found" << std::endl;
+		return 1;
+	}
+	intcode::Data input;
+	for (int i = 2; i < argc; i++) {
+		input.push_back(std::stoll(argv[i]));
+	}
+
+	auto program = intcode::get_program_for_memory_with_input_data(intcode::get_memory_from_string(source), input);
+	intcode::Console console(STDIN_FILENO, STDOUT_FILENO);
+	try {
+		if (console.run(program.at(0)) == intcode::Event::INPUT) {
+			std::cerr << "input ended while the program waits for more" << std::endl;
+			return 2;
+		}
+	} catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,44 @@
+// intcode-profile : Profiles an Intcode program on the decoded interpreter.
+//
+// Usage: intcode-profile <puzzle_input> <json|folded> [input...]
+//
+// The puzzle input holds the program as its first string literal. The
+// program runs until it halts or wants more input than given; the profile
+// goes to standard output. Only built with INTCODE_PROFILE enabled.
+
+#include <iostream>
+#include <string>
+
+#include "../days/intcode/intcode.hpp"
+#include "../days/utils.hpp"
+
+int main(int argc, char* argv[]) {
+	std::string format = argc > 2 ? argv[2] : "";
+	if (format != "json" && format != "folded") {
+		std::cerr << "usage: " << argv[0] << " <puzzle_input> <json|folded> [input...]" << std::endl;
+		return 1;
+	}
+	auto source = read_program(argv[1]);
+	if (source.find_first_of("0123456789") == std::string::npos) {
+		std::cerr << argv[1] << ": no program found" << std::endl;
+		return 1;
+	}
+	intcode::Data input;
+	for (int i = 3; i < argc; i++) {
+		input.push_back(std::stoll(argv[i]));
+	}
+
+	auto program = intcode::get_program_for_memory_with_input_data(intcode::get_memory_from_string(source), input);
+	auto& comp = program.at(0);
+	intcode::Profiler profiler;
+	comp.cpu.profiler = &profiler;
+	if (comp.run().event == intcode::Event::INPUT) {
+		std::cerr << "stopped waiting for input" << std::endl;
+	}
+	if (format == "json") {
+		profiler.write_json(std::cout);
+	} else {
+		profiler.write_folded(std::cout);
+	}
+	return 0;
+}
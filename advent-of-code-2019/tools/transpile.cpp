@@ -0,0 +1,206 @@
+// intcode-transpile : Translates an Intcode program into a C++ translation unit.
+//
+// Usage: intcode-transpile <name> <puzzle_input> <output.cpp>
+//
+// The puzzle input holds the program as its first string literal. The
+// generated unit registers an intcode::Translation running every statically
+// reachable instruction as straight-line C++ behind a jump table keyed by
+// instruction pointer.
+
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../days/intcode/analysis.hpp"
+#include "../days/intcode/intcode.hpp"
+#include "../days/utils.hpp"
+
+namespace {
+
+using intcode::Operation;
+using intcode::Parameter;
+using intcode::Type;
+using intcode::Value;
+
+std::string literal(Value value) {
+	if (value == std::numeric_limits<Value>::min()) {
+		return "std::numeric_limits<intcode::Value>::min()";
+	}
+	return std::to_string(value);
+}
+
+class Transpiler {
+public:
+	Transpiler(const intcode::Analysis& analysis) :
+		memory(analysis.get_memory()),
+		owners(analysis.get_owners()),
+		operations(analysis.get_instructions()) {}
+
+	void generate(std::ostream& os, const std::string& name, const std::string& source) {
+		os << "// Generated by intcode-transpile from " << source << ", do not edit.\n\n";
+		os << "#include <iterator>\n#include <limits>\n\n";
+		os << "#include \"days/intcode/compiled.hpp\"\n\n";
+		os << "namespace {\n\n";
+		os << "using namespace intcode::compiled;\nusing intcode::Value;\n\n";
+		os << "const intcode::Value image[] = {";
+		write_values(os, memory);
+		os << "};\n\n";
+		os << "const intcode::Value owners[] = {";
+		write_values(os, owners);
+		os << "};\n\n";
+		os << "intcode::Value run(Frame& frame, intcode::Value ip) {\n";
+		os << "\t[[maybe_unused]] auto& base = frame.cpu.base;\n";
+		os << "\tfor (;;) {\n";
+		os << "\t\tswitch (ip) {\n";
+		for (auto it = operations.begin(); it != operations.end(); ++it) {
+			auto [ip, op] = *it;
+			auto next = ip + op.length;
+			os << "\t\tcase " << ip << ":\n";
+			if (!is_translated(op)) {
+				os << "\t\t\treturn " << ip << ";\n";
+				continue;
+			}
+			os << "\t\t\tif (!frame.alive[" << ip << "]) {\n\t\t\t\treturn " << ip << ";\n\t\t\t}\n";
+			write_operation(os, ip, op);
+			auto following = std::next(it);
+			if (following != operations.end() && following->first == next) {
+				os << "\t\t\t[[fallthrough]];\n";
+			} else {
+				os << "\t\t\treturn " << next << ";\n";
+			}
+		}
+		os << "\t\tdefault:\n\t\t\treturn ip;\n";
+		os << "\t\t}\n\t}\n}\n\n";
+		os << "} // namespace\n\n";
+		os << "const bool " << name << "_registered = intcode::register_translation({\"" << name << "\", "
+			<< "image, std::size(image), owners, run});\n";
+	}
+
+private:
+	static Parameter::Mode mode(const Operation& op, int i) {
+		return static_cast<Parameter::Mode>(op.modes[i]);
+	}
+
+	static bool is_translated(const Operation& op) {
+		return op.opcode != Type::INPUT && op.opcode != Type::OUTPUT && op.opcode != Type::STOP;
+	}
+
+	// Value of the operand itself, read from its cell when patched.
+	std::string operand(Value ip, const Operation& op, int i) {
+		auto cell = ip + 1 + i;
+		if (owners[cell] != ip) {
+			std::string text = "load(frame, ";
+			text += literal(cell);
+			text += ")";
+			return text;
+		}
+		return literal(op.operands[i]);
+	}
+
+	std::string address(Value ip, const Operation& op, int i) {
+		std::string text;
+		if (mode(op, i) == Parameter::Mode::RELATIVE) {
+			text += "base + ";
+		}
+		text += operand(ip, op, i);
+		return text;
+	}
+
+	std::string read(Value ip, const Operation& op, int i) {
+		std::string text;
+		if (mode(op, i) == Parameter::Mode::IMMEDIATE) {
+			text += "Value{";
+			text += operand(ip, op, i);
+			text += "}";
+		} else {
+			text += "load(frame, ";
+			text += address(ip, op, i);
+			text += ")";
+		}
+		return text;
+	}
+
+	// Both inputs of `op` joined by `infix`, as 1 or 0 for comparisons.
+	std::string combine(Value ip, const Operation& op, const char* infix, bool compare = false) {
+		std::string text = compare ? "(" : "";
+		text += read(ip, op, 0);
+		text += infix;
+		text += read(ip, op, 1);
+		if (compare) {
+			text += ") ? 1 : 0";
+		}
+		return text;
+	}
+
+	void write_operation(std::ostream& os, Value ip, const Operation& op) {
+		auto next = ip + op.length;
+		auto store = [&](const std::string& value) {
+			os << "\t\t\tif (store(frame, " << address(ip, op, 2) << ", " << value << ")) {\n"
+				<< "\t\t\t\treturn " << next << ";\n\t\t\t}\n";
+		};
+		auto jump = [&](const std::string& condition) {
+			os << "\t\t\tif (" << read(ip, op, 0) << condition << ") {\n"
+				<< "\t\t\t\tip = " << read(ip, op, 1) << ";\n\t\t\t\tcontinue;\n\t\t\t}\n";
+		};
+		switch (op.opcode) {
+		case Type::ADD:
+			store(combine(ip, op, " + "));
+			break;
+		case Type::MULTIPLY:
+			store(combine(ip, op, " * "));
+			break;
+		case Type::LT:
+			store(combine(ip, op, " < ", true));
+			break;
+		case Type::EQ:
+			store(combine(ip, op, " == ", true));
+			break;
+		case Type::JNZ:
+			jump(" != 0");
+			break;
+		case Type::JZ:
+			jump(" == 0");
+			break;
+		case Type::BASE:
+			os << "\t\t\tbase += " << read(ip, op, 0) << ";\n";
+			break;
+		default:
+			break;
+		}
+	}
+
+	template<typename Values>
+	static void write_values(std::ostream& os, const Values& values) {
+		for (std::size_t i = 0; i < values.size(); i++) {
+			os << (i % 16 ? " " : "\n\t") << literal(values[i]) << ",";
+		}
+		os << "\n";
+	}
+
+	const intcode::Memory& memory;
+	const std::vector<Value>& owners;
+	const std::map<Value, Operation>& operations;
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+	if (argc != 4) {
+		std::cerr << "usage: " << argv[0] << " <name> <puzzle_input> <output.cpp>" << std::endl;
+		return 1;
+	}
+	auto program = read_program(argv[2]);
+	if (program.find_first_of("0123456789") == std::string::npos) {
+		std::cerr << argv[2] << ": no program found" << std::endl;
+		return 1;
+	}
+	auto memory = intcode::get_memory_from_string(program);
+	Transpiler transpiler(intcode::get_analysis(memory));
+
+	std::ofstream output(argv[3]);
+	transpiler.generate(output, argv[1], argv[2]);
+	return output ? 0 : 1;
+}